@@ -2,38 +2,122 @@
 #include <iomanip>
 #include <string> // For std::string
 #include <limits>
+#include <vector>
+#include <memory>
 
 using namespace std;
 
+// Amount of money in centavos (1/100 peso), so bills and gross income add up exactly
+struct Money {
+    long long centavos = 0;
+
+    Money operator+(Money o) const { return {centavos + o.centavos}; }
+    Money operator-(Money o) const { return {centavos - o.centavos}; }
+    Money& operator+=(Money o) { centavos += o.centavos; return *this; }
+    Money& operator-=(Money o) { centavos -= o.centavos; return *this; }
+    Money operator*(int n) const { return {centavos * n}; }
+    bool operator==(Money o) const { return centavos == o.centavos; }
+};
+
+// Whole pesos as Money
+Money pesos(long long whole) {
+    return {whole * 100};
+}
+
+// Parse a peso amount such as "50", "12.5" or "12.25" (at most two decimals)
+bool parseMoney(const string& s, Money& out) {
+    size_t dot = s.find('.');
+    string whole = s.substr(0, dot);
+    string frac = dot == string::npos ? "" : s.substr(dot + 1);
+    if ((whole.empty() && frac.empty()) || whole.size() > 15 || frac.size() > 2) return false;
+    long long c = 0;
+    for (char ch : whole + frac + string(2 - frac.size(), '0')) {
+        if (ch < '0' || ch > '9') return false;
+        c = c * 10 + (ch - '0');
+    }
+    out.centavos = c;
+    return true;
+}
+
+// Print as pesos with two decimals, e.g. "1234.50" (setw and left apply)
+ostream& operator<<(ostream& os, Money m) {
+    long long a = m.centavos < 0 ? -m.centavos : m.centavos;
+    string text = (m.centavos < 0 ? "-" : "") + to_string(a / 100) + "." + char('0' + a % 100 / 10) + char('0' + a % 10);
+    return os << text;
+}
+
 const int MAX_SIZE = 20; // Maximum size of the menu
 int SIZE = 6; // Current number of items
 string menuItems[MAX_SIZE] = {"Sisig with pilok", "Buko with magic sugar", "Java rice", "Tempura nga high class", "Melon Juice", "Iced Coffee"};
-double prices[MAX_SIZE] = {50, 10, 50, 20, 15, 25};
+Money prices[MAX_SIZE] = {pesos(50), pesos(10), pesos(50), pesos(20), pesos(15), pesos(25)};
 int stock[MAX_SIZE] = {10, 5, 7, 20, 50, 50}; // Updated stock for new items
 string categories[MAX_SIZE] = {"Food", "Drink", "Food", "Food", "Drink", "Drink"};
+bool removed[MAX_SIZE] = {false}; // Tombstones: removed items keep their slot until the menu is compacted
+int removedCount = 0;
+
+Money grossIncome; // Global variable to track the gross income
 
-double grossIncome = 0.0; // Global variable to track the gross income
+// One line of a bill, as kept in the order history
+struct OrderRecord {
+    string item;
+    int quantity;
+    Money cost;
+    string paymentMethod;
+};
+
+// Order history, stored in fixed-size chunks that are allocated as needed
+// Appending never moves or copies earlier records, and there is no limit on the number of lines
+const int ORDER_CHUNK_SIZE = 256;
+struct OrderLog {
+    vector<unique_ptr<OrderRecord[]>> chunks;
+    int count = 0;
+
+    void append(const OrderRecord& record) {
+        if (count % ORDER_CHUNK_SIZE == 0) chunks.push_back(make_unique<OrderRecord[]>(ORDER_CHUNK_SIZE));
+        chunks[count / ORDER_CHUNK_SIZE][count % ORDER_CHUNK_SIZE] = record;
+        count++;
+    }
+    const OrderRecord& operator[](int i) const { return chunks[i / ORDER_CHUNK_SIZE][i % ORDER_CHUNK_SIZE]; }
+};
 
-// Order history arrays
-const int MAX_ORDERS = 100;
-string orderItems[MAX_ORDERS];
-int orderQuantities[MAX_ORDERS];
-double orderCosts[MAX_ORDERS];
-string orderPaymentMethods[MAX_ORDERS];
-int orderCount = 0; // Total number of orders recorded
+OrderLog orderHistory;
 
 // Function to display the menu
+// Items keep their numbers until the menu is compacted, so removed items leave gaps
 void displayMenu() {
     cout << "\n--- Menu ---\n";
     for (int i = 0; i < SIZE; i++) {
+        if (removed[i]) continue;
         cout << i + 1 << ". " << menuItems[i] << " - " << fixed << setprecision(2) << prices[i]
              << " pesos (Stock: " << stock[i] << ")\n";
     }
 }
 
+// Function to check that an item number refers to an item on the menu
+bool isMenuItem(int itemNumber) {
+    return itemNumber >= 1 && itemNumber <= SIZE && !removed[itemNumber - 1];
+}
+
+// Function to move the remaining items down over the removed ones in a single pass
+void compactMenu() {
+    int kept = 0;
+    for (int i = 0; i < SIZE; i++) {
+        if (removed[i]) continue;
+        menuItems[kept] = menuItems[i];
+        prices[kept] = prices[i];
+        stock[kept] = stock[i];
+        categories[kept] = categories[i];
+        removed[kept] = false;
+        kept++;
+    }
+    for (int i = kept; i < SIZE; i++) removed[i] = false;
+    SIZE = kept;
+    removedCount = 0;
+}
+
 // Function to generate and display the bill
 void generateBill(const int orders[], const string& paymentMethod) {
-    double total = 0;
+    Money total;
 
     cout << "\n--- Bill Summary ---\n";
     cout << left << setw(25) << "Item" << setw(10) << "Qty" << setw(20) << "Total Cost" << endl;
@@ -42,17 +126,13 @@ void generateBill(const int orders[], const string& paymentMethod) {
     bool hasOrder = false;
     for (int i = 0; i < SIZE; i++) {
         if (orders[i] > 0) {
-            double cost = orders[i] * prices[i]; // Calculating cost based on quantity and price
+            Money cost = prices[i] * orders[i]; // Calculating cost based on quantity and price
             total += cost;
             cout << left << setw(25) << menuItems[i] << setw(10) << orders[i] << cost << " pesos" << endl;
             hasOrder = true;
 
             // Store order in history
-            orderItems[orderCount] = menuItems[i];
-            orderQuantities[orderCount] = orders[i];
-            orderCosts[orderCount] = cost;
-            orderPaymentMethods[orderCount] = paymentMethod;
-            orderCount++;
+            orderHistory.append({menuItems[i], orders[i], cost, paymentMethod});
         }
     }
 
@@ -65,7 +145,7 @@ void generateBill(const int orders[], const string& paymentMethod) {
 }
 
 // Function to handle payment method selection
-void selectPaymentMethod(string& paymentMethod, double total) {
+void selectPaymentMethod(string& paymentMethod, Money total) {
     int paymentChoice;
     int attemptCounter = 0;
     const int maxAttempts = 3; // Set maximum attempts to avoid infinite loop
@@ -137,7 +217,7 @@ void placeOrder() {
     char choice;
     int itemChoice, quantity;
     string paymentMethod;
-    double total = 0;
+    Money total;
 
     int tempOrders[MAX_SIZE] = {0}; // Temporary orders array for user to confirm before finalizing
     int orders[MAX_SIZE] = {0}; // Reset orders array for each user
@@ -166,7 +246,7 @@ void placeOrder() {
         if (choice == '0') break;
         if (choice == 'b') return;
         itemChoice = choice - '0';
-        if (itemChoice < 1 || itemChoice > SIZE) {
+        if (!isMenuItem(itemChoice)) {
             cout << "Invalid choice. Try again.\n";
             continue;
         }
@@ -338,7 +418,7 @@ void adminPanel() {
             }
 
             if (itemIndex == 0) continue;
-            if (itemIndex < 1 || itemIndex > SIZE) {
+            if (!isMenuItem(itemIndex)) {
                 cout << "Invalid item number.\n";
                 continue;
             }
@@ -357,17 +437,22 @@ void adminPanel() {
         } else if (choice == 2) { // View gross income
             cout << "\nGross Income: " << fixed << setprecision(2) << grossIncome << " pesos\n";
         } else if (choice == 3) { // Add new item
+            if (SIZE == MAX_SIZE && removedCount > 0) compactMenu(); // Reuse the slots of removed items
             if (SIZE < MAX_SIZE) {
-                string newItem;
-                double newPrice;
+                string newItem, priceText;
+                Money newPrice;
                 int newStock;
                 cout << "Enter new item name (0 to cancel): ";
                 cin.ignore(); // Clear newline
                 getline(cin, newItem);
                 if (newItem == "0") continue;
                 cout << "Enter price: ";
-                cin >> newPrice;
-                if (newPrice == 0) continue;
+                cin >> priceText;
+                if (!parseMoney(priceText, newPrice)) {
+                    cout << "Invalid price. Use pesos with at most two decimals.\n";
+                    continue;
+                }
+                if (newPrice == Money()) continue;
                 cout << "Enter stock: ";
                 cin >> newStock;
                 if (newStock == 0) continue;
@@ -375,6 +460,7 @@ void adminPanel() {
                 menuItems[SIZE] = newItem;
                 prices[SIZE] = newPrice;
                 stock[SIZE] = newStock;
+                removed[SIZE] = false;
                 SIZE++; // Increase the size of the menu
                 cout << "Item added successfully!\n";
             } else {
@@ -394,24 +480,22 @@ void adminPanel() {
             }
 
             if (itemIndex == 0) continue;
-            if (itemIndex < 1 || itemIndex > SIZE) {
+            if (!isMenuItem(itemIndex)) {
                 cout << "Invalid item number.\n";
                 continue;
             }
 
-            // Shift items to remove the selected item
-            for (int i = itemIndex - 1; i < SIZE - 1; i++) {
-                menuItems[i] = menuItems[i + 1];
-                prices[i] = prices[i + 1];
-                stock[i] = stock[i + 1];
-            }
-
-            SIZE--; // Decrease the size of the menu
+            // Mark the item removed instead of shifting every later item down
+            removed[itemIndex - 1] = true;
+            removedCount++;
+            // Compact once half the slots are tombstones
+            if (removedCount * 2 >= SIZE) compactMenu();
             cout << "Item removed successfully!\n";
         } else if (choice == 5) { // View order history
             cout << "\n--- Order History ---\n";
-            for (int i = 0; i < orderCount; i++) {
-                cout << left << setw(25) << orderItems[i] << setw(10) << orderQuantities[i] << orderCosts[i] << " pesos (Payment Method: " << orderPaymentMethods[i] << ")\n";
+            for (int i = 0; i < orderHistory.count; i++) {
+                const OrderRecord& record = orderHistory[i]; // Read in place, no copy
+                cout << left << setw(25) << record.item << setw(10) << record.quantity << record.cost << " pesos (Payment Method: " << record.paymentMethod << ")\n";
             }
         } else if (choice == 0) {
             break;
@@ -9,6 +9,36 @@
 #include <random>
 #include <ctime>
 #include <sstream>
+#include <string_view>
+#include <cmath>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <unordered_set>
+#include <unordered_map>
+#include <queue>
+#include <deque>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+#include <cstddef>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -19,108 +49,1822 @@ const int W_CAT   = 22;
 const int W_QTY   = 10;
 const int W_PRICE = 12;
 
+// Amount of money as a whole number of centavos (1/100 peso), so prices, totals and
+// inventory values add up exactly instead of drifting like binary floating point
+struct Money {
+    int64_t centavos = 0;
+
+    static Money fromCentavos(int64_t c) {
+        Money m;
+        m.centavos = c;
+        return m;
+    }
+    Money operator+(Money o) const { return fromCentavos(centavos + o.centavos); }
+    Money& operator+=(Money o) {
+        centavos += o.centavos;
+        return *this;
+    }
+    // Prices and quantities are kept within MAX_PRICE_CENTAVOS and MAX_QUANTITY, so this fits
+    Money operator*(int64_t n) const { return fromCentavos(centavos * n); }
+    bool operator==(Money o) const { return centavos == o.centavos; }
+    bool operator!=(Money o) const { return centavos != o.centavos; }
+    bool operator<(Money o) const { return centavos < o.centavos; }
+    bool operator>(Money o) const { return centavos > o.centavos; }
+    bool operator<=(Money o) const { return centavos <= o.centavos; }
+    bool operator>=(Money o) const { return centavos >= o.centavos; }
+};
+static_assert(sizeof(Money) == sizeof(int64_t), "prices are stored and scanned as raw int64 centavos");
+
+// Largest accepted price and stock level: price * quantity of one product stays below 2^54
+// centavos, and sums over many products are checked with addMoney()
+const int64_t MAX_PRICE_CENTAVOS = 10000000000LL; // 100,000,000.00 pesos
+const int MAX_QUANTITY = 1000000;
+
+// Add 'amount' to 'total'; returns false, leaving 'total' unchanged, if the sum does not fit
+bool addMoney(Money& total, Money amount) {
+    int64_t a = total.centavos, b = amount.centavos;
+    if (b > 0 ? a > numeric_limits<int64_t>::max() - b : a < numeric_limits<int64_t>::min() - b) return false;
+    total.centavos = a + b;
+    return true;
+}
+
+// Parse a peso amount such as "350", "99.5" or "12.25" into centavos
+// Amounts with more than two decimals are rejected, unless 'roundExtraDecimals' is set (for files
+// written before prices were exact), which rounds them half up; amounts above the maximum price
+// are always rejected
+bool parseMoney(string_view s, Money& out, bool roundExtraDecimals = false) {
+    size_t dot = s.find('.');
+    string_view whole = s.substr(0, dot);
+    string_view frac = dot == string_view::npos ? string_view() : s.substr(dot + 1);
+    if (whole.empty() && frac.empty()) return false;
+    if (whole.size() > 15) return false; // Far above the maximum price
+    if (frac.size() > 2 && !roundExtraDecimals) return false;
+    int64_t c = 0;
+    for (char ch : whole) {
+        if (ch < '0' || ch > '9') return false;
+        c = c * 10 + (ch - '0');
+    }
+    for (size_t i = 0; i < frac.size(); ++i) {
+        char ch = frac[i];
+        if (ch < '0' || ch > '9') return false;
+        if (i < 2) c = c * 10 + (ch - '0');
+        else if (i == 2 && ch >= '5') c++;
+    }
+    for (size_t i = frac.size(); i < 2; ++i) c *= 10;
+    if (c > MAX_PRICE_CENTAVOS) return false;
+    out = Money::fromCentavos(c);
+    return true;
+}
+
+// Format an amount as pesos with exactly two decimals, e.g. "1234.50"
+string formatMoney(Money m) {
+    int64_t c = m.centavos;
+    string out = c < 0 ? "-" : "";
+    uint64_t a = c < 0 ? -(uint64_t)c : c;
+    out += to_string(a / 100);
+    out += '.';
+    out += char('0' + a % 100 / 10);
+    out += char('0' + a % 10);
+    return out;
+}
+
+// Printed like a string, so setw and left apply
+ostream& operator<<(ostream& os, Money m) {
+    return os << formatMoney(m);
+}
+
 // Product structure to store product details
+// Used for products being read or entered; the store keeps them in columns (see ProductStore)
 struct Product {
     int id;
     string name;
     string category;
     int quantity;
-    double price;
+    Money price;
+};
+
+// Category dictionary: each distinct category name gets a small integer ID
+// in order of first appearance, with the list of products in that category
+// Names sit in a deque so the views used as map keys never move
+deque<string> categoryNames;                 // Category ID -> name
+unordered_map<string_view, int> categoryIds; // Name -> category ID
+vector<vector<int>> categoryMembers;         // Category ID -> ascending indices in products
+
+// Return the ID of a category name, adding it to the dictionary if it is new
+int internCategory(string_view name) {
+    auto it = categoryIds.find(name);
+    if (it != categoryIds.end()) return it->second;
+    int id = categoryNames.size();
+    categoryNames.emplace_back(name);
+    categoryIds.emplace(categoryNames.back(), id);
+    categoryMembers.emplace_back();
+    return id;
+}
+
+// Bump allocator for strings: each string is appended to one buffer, followed by a '\0'
+// separator, and referred to by offset and length; clear() releases them all at once
+struct StringArena {
+    string bytes;
+
+    uint32_t add(string_view s) {
+        uint32_t offset = bytes.size();
+        bytes.append(s);
+        bytes += '\0';
+        return offset;
+    }
+    string_view get(uint32_t offset, uint32_t length) const { return string_view(bytes.data() + offset, length); }
+    void clear() { bytes.clear(); } // Keeps the capacity for the next load
+};
+
+// Access to one stored product; the numeric members refer into the store's columns
+// The name is a view into the name arena, valid until the store changes
+struct ProductRef {
+    int& id;
+    string_view name;
+    const string& category;
+    int& quantity;
+    Money& price;
+    int& categoryId;
+};
+
+// The catalog, stored as one column per field (structure of arrays) and indexed by slot
+// Reports and valuations scan the numeric columns without pulling names into cache
+// Names live back to back in one arena, so a product costs no string allocations and
+// searches scan a single buffer; categories are interned in the category dictionary
+// A removed product leaves a tombstone in its slot, so no other product moves; compact()
+// squeezes the tombstones out
+struct ProductStore {
+    vector<int> id;
+    vector<int> quantity;
+    vector<Money> price;
+    vector<int> categoryId;
+    vector<uint32_t> nameOffset; // Name of each product in the arena (ascending with slot)
+    vector<uint32_t> nameLength;
+    StringArena names;           // May also hold names of removed products until the next compact()
+    vector<uint8_t> live;        // 0 for a tombstone
+    size_t tombstones = 0;
+
+    size_t size() const { return id.size(); } // Slots, including tombstones
+    bool empty() const { return id.empty(); }
+    size_t liveCount() const { return id.size() - tombstones; }
+    bool isLive(size_t slot) const { return live[slot]; }
+    ProductRef operator[](size_t slot) {
+        return {id[slot], names.get(nameOffset[slot], nameLength[slot]), categoryNames[categoryId[slot]],
+                quantity[slot], price[slot], categoryId[slot]};
+    }
+    void push_back(const Product& p) {
+        id.push_back(p.id);
+        quantity.push_back(p.quantity);
+        price.push_back(p.price);
+        categoryId.push_back(internCategory(p.category));
+        nameOffset.push_back(names.add(p.name));
+        nameLength.push_back(p.name.size());
+        live.push_back(1);
+    }
+    // Mark the product at 'slot' removed in O(1)
+    // Its quantity is zeroed so column scans add nothing for it
+    void tombstone(size_t slot) {
+        live[slot] = 0;
+        quantity[slot] = 0;
+        tombstones++;
+    }
+    // Move the live products down over the tombstones, keeping their order, and rewrite the
+    // name arena without the removed names; every slot may change
+    void compact() {
+        StringArena kept;
+        kept.bytes.reserve(names.bytes.size());
+        size_t out = 0;
+        for (size_t i = 0; i < size(); ++i) {
+            if (!live[i]) continue;
+            id[out] = id[i];
+            quantity[out] = quantity[i];
+            price[out] = price[i];
+            categoryId[out] = categoryId[i];
+            nameOffset[out] = kept.add(names.get(nameOffset[i], nameLength[i]));
+            nameLength[out] = nameLength[i];
+            out++;
+        }
+        id.resize(out);
+        quantity.resize(out);
+        price.resize(out);
+        categoryId.resize(out);
+        nameOffset.resize(out);
+        nameLength.resize(out);
+        names = move(kept);
+        live.assign(out, 1);
+        tombstones = 0;
+    }
+    void reserve(size_t n) {
+        id.reserve(n);
+        quantity.reserve(n);
+        price.reserve(n);
+        categoryId.reserve(n);
+        nameOffset.reserve(n);
+        nameLength.reserve(n);
+        live.reserve(n);
+    }
+    // Drop every product, the name arena and the category dictionary
+    void clear() {
+        id.clear();
+        quantity.clear();
+        price.clear();
+        categoryId.clear();
+        nameOffset.clear();
+        nameLength.clear();
+        live.clear();
+        tombstones = 0;
+        names.clear();
+        categoryNames.clear();
+        categoryIds.clear();
+        categoryMembers.clear();
+    }
+};
+
+ProductStore products;
+
+// Stable reference to a product: its slot in products plus the generation stamped on that
+// slot when the product was placed there. Reloads and removals restamp slots, so a handle
+// that outlived its product is detected instead of silently reading another product
+struct ProductHandle {
+    int slot = -1;
+    uint64_t generation = 0;
+};
+
+vector<uint64_t> slotGeneration;   // Slot -> generation of the product stored there
+uint64_t nextSlotGeneration = 1;   // Never reused, so old handles can never match again
+
+// Stamp the product placed at 'slot' with a fresh generation
+void stampSlot(int slot) {
+    if (slotGeneration.size() <= (size_t)slot) slotGeneration.resize(slot + 1);
+    slotGeneration[slot] = nextSlotGeneration++;
+}
+
+// Handle to the product currently at 'slot'
+ProductHandle handleOf(int slot) {
+    return {slot, slotGeneration[slot]};
+}
+
+// Slot of the product a handle refers to, or -1 if the handle is stale
+int resolveHandle(const ProductHandle& h) {
+    if (h.slot < 0 || (size_t)h.slot >= products.size() || slotGeneration[h.slot] != h.generation) return -1;
+    return h.slot;
+}
+
+// Returned by findProduct when a name matches more than one product
+const int AMBIGUOUS_MATCH = -2;
+
+// Remove leading and trailing whitespace from a string
+string trim(string_view s) {
+    size_t first = s.find_first_not_of(" \t\r\n");
+    if (first == string_view::npos) return "";
+    size_t last = s.find_last_not_of(" \t\r\n");
+    return string(s.substr(first, last - first + 1));
+}
+
+// Return a lowercased copy of a string
+string lowercase(string_view s) {
+    string out(s);
+    for (char& c : out) c = tolower(static_cast<unsigned char>(c));
+    return out;
+}
+
+// Key used by the name index: trimmed and lowercased
+string nameKey(string_view name) {
+    return lowercase(trim(name));
+}
+
+// Return the distinct trigrams (three consecutive bytes packed into an int) of a lowercased string
+vector<uint32_t> trigramsOf(const string& lower) {
+    vector<uint32_t> grams;
+    for (size_t i = 0; i + 3 <= lower.size(); ++i) {
+        grams.push_back(static_cast<unsigned char>(lower[i]) << 16
+                      | static_cast<unsigned char>(lower[i + 1]) << 8
+                      | static_cast<unsigned char>(lower[i + 2]));
+    }
+    sort(grams.begin(), grams.end());
+    grams.erase(unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+// Case-insensitive (ASCII) substring kernels
+// Each returns the position of the first occurrence of a lowercase 'needle' of length m
+// (m >= 1) in text[0, n), or n if there is none
+typedef size_t (*SubstringKernel)(const char* text, size_t n, const char* needle, size_t m);
+
+inline char foldAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// Compare text[0, m) against a lowercase needle, ignoring ASCII case
+inline bool equalsFolded(const char* text, const char* needle, size_t m) {
+    for (size_t k = 0; k < m; ++k)
+        if (foldAscii(text[k]) != needle[k]) return false;
+    return true;
+}
+
+size_t findFoldedScalar(const char* text, size_t n, const char* needle, size_t m) {
+    for (size_t i = 0; i + m <= n; ++i)
+        if (foldAscii(text[i]) == needle[0] && equalsFolded(text + i, needle, m)) return i;
+    return n;
+}
+
+#ifdef HAVE_X86_SIMD
+// Lowercase the ASCII capitals in 16 bytes
+inline __m128i foldAscii16(__m128i v) {
+    __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - 'A')));
+    __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+// Compare the first and last needle bytes at 16 positions at once; verify only the hits
+size_t findFoldedSse2(const char* text, size_t n, const char* needle, size_t m) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i a = foldAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)));
+        __m128i b = foldAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + m - 1)));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (equalsFolded(text + i + bit, needle, m)) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+    size_t rest = findFoldedScalar(text + i, n - i, needle, m);
+    return rest == n - i ? n : i + rest;
+}
+
+__attribute__((target("avx2")))
+inline __m256i foldAscii32(__m256i v) {
+    __m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(0x80 - 'A')));
+    __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+    return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+// Same as the SSE2 kernel, 32 positions at a time
+__attribute__((target("avx2")))
+size_t findFoldedAvx2(const char* text, size_t n, const char* needle, size_t m) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i a = foldAscii32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)));
+        __m256i b = foldAscii32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + m - 1)));
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (equalsFolded(text + i + bit, needle, m)) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+    _mm256_zeroupper(); // Avoid the AVX-to-SSE transition penalty in the SSE2 tail
+    size_t rest = findFoldedSse2(text + i, n - i, needle, m);
+    return rest == n - i ? n : i + rest;
+}
+#endif
+
+// Pick the fastest kernel the CPU supports
+SubstringKernel selectSubstringKernel() {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return findFoldedAvx2;
+    return findFoldedSse2;
+#else
+    return findFoldedScalar;
+#endif
+}
+
+SubstringKernel findFolded = selectSubstringKernel();
+
+// Radix trie node over lowercased product names, used for type-ahead completion
+// Nodes live in one vector and refer to each other by index
+struct NameTrieNode {
+    string edge;          // Label of the edge leading into this node
+    vector<int> children; // Child nodes, sorted by the first byte of their edge
+    vector<int> slots;    // Products whose name ends at this node
+};
+
+vector<NameTrieNode> nameTrie(1); // Node 0 is the root
+vector<int> freeTrieNodes;         // Nodes pruned by trieRemove, reused by trieInsert
+
+// Store a node in a free entry of the trie (or a new one) and return its index
+int newTrieNode(NameTrieNode n) {
+    if (freeTrieNodes.empty()) {
+        nameTrie.push_back(move(n));
+        return nameTrie.size() - 1;
+    }
+    int node = freeTrieNodes.back();
+    freeTrieNodes.pop_back();
+    nameTrie[node] = move(n);
+    return node;
+}
+
+// Release a node that is no longer linked into the trie
+void freeTrieNode(int node) {
+    nameTrie[node] = NameTrieNode();
+    freeTrieNodes.push_back(node);
+}
+
+// Find the child of 'node' whose edge starts with 'c' (-1 if none)
+// Also returns the position where such a child would be inserted
+int trieChild(int node, char c, size_t& pos) {
+    const vector<int>& kids = nameTrie[node].children;
+    pos = 0;
+    while (pos < kids.size() && nameTrie[kids[pos]].edge[0] < c) ++pos;
+    return pos < kids.size() && nameTrie[kids[pos]].edge[0] == c ? kids[pos] : -1;
+}
+
+// Insert a lowercased name into the trie, splitting edges where needed
+void trieInsert(const string& key, int slot) {
+    int node = 0;
+    size_t i = 0;
+    while (i < key.size()) {
+        size_t pos;
+        int child = trieChild(node, key[i], pos);
+        if (child == -1) {
+            int leaf = newTrieNode({key.substr(i), {}, {slot}});
+            nameTrie[node].children.insert(nameTrie[node].children.begin() + pos, leaf);
+            return;
+        }
+        const string& edge = nameTrie[child].edge;
+        size_t common = 0;
+        while (common < edge.size() && i + common < key.size() && edge[common] == key[i + common]) ++common;
+        if (common < edge.size()) {
+            // Split the edge: a new middle node takes the shared part
+            NameTrieNode middle{edge.substr(0, common), {child}, {}};
+            nameTrie[child].edge.erase(0, common);
+            int mid = newTrieNode(move(middle));
+            nameTrie[node].children[pos] = mid;
+            child = mid;
+        }
+        node = child;
+        i += common;
+    }
+    nameTrie[node].slots.push_back(slot);
+}
+
+// Remove a product from the node of its lowercased name
+// Nodes left with no products and no children are pruned, and an empty node left with a single
+// child is merged with it, so completion never walks through names that were deleted
+void trieRemove(const string& key, int slot) {
+    vector<pair<int, size_t>> path; // Parent and child position of every edge followed
+    int node = 0;
+    size_t i = 0;
+    while (i < key.size()) {
+        size_t pos;
+        int child = trieChild(node, key[i], pos);
+        if (child == -1 || nameTrie[child].edge.compare(0, string::npos, key, i, nameTrie[child].edge.size()) != 0) return;
+        path.push_back({node, pos});
+        node = child;
+        i += nameTrie[child].edge.size();
+    }
+    vector<int>& slots = nameTrie[node].slots;
+    slots.erase(remove(slots.begin(), slots.end(), slot), slots.end());
+
+    while (!path.empty() && nameTrie[node].slots.empty() && nameTrie[node].children.empty()) {
+        auto [parent, pos] = path.back();
+        path.pop_back();
+        nameTrie[parent].children.erase(nameTrie[parent].children.begin() + pos);
+        freeTrieNode(node);
+        node = parent;
+    }
+    if (!path.empty() && nameTrie[node].slots.empty() && nameTrie[node].children.size() == 1) {
+        int child = nameTrie[node].children[0];
+        nameTrie[node].edge += nameTrie[child].edge;
+        nameTrie[node].slots = move(nameTrie[child].slots);
+        nameTrie[node].children = move(nameTrie[child].children);
+        freeTrieNode(child);
+    }
+}
+
+// Return up to 'limit' products whose name starts with 'prefix', in alphabetical order
+// Cost grows with the prefix length and the number of results, not the catalog size
+vector<int> completeProductName(const string& prefix, size_t limit) {
+    string key = lowercase(prefix);
+    int node = 0;
+    size_t i = 0;
+    while (i < key.size()) {
+        size_t pos;
+        int child = trieChild(node, key[i], pos);
+        if (child == -1) return {};
+        const string& edge = nameTrie[child].edge;
+        size_t len = min(edge.size(), key.size() - i);
+        if (edge.compare(0, len, key, i, len) != 0) return {};
+        node = child;
+        i += len;
+    }
+    vector<int> result;
+    vector<int> stack{node};
+    while (!stack.empty() && result.size() < limit) {
+        int n = stack.back();
+        stack.pop_back();
+        for (int slot : nameTrie[n].slots) {
+            if (result.size() == limit) break;
+            result.push_back(slot);
+        }
+        const vector<int>& kids = nameTrie[n].children;
+        for (auto it = kids.rbegin(); it != kids.rend(); ++it) stack.push_back(*it);
+    }
+    return result;
+}
+
+// Return the IDs of all categories that currently have products, in order of first appearance
+vector<int> getCategories() {
+    vector<int> cats;
+    for (size_t c = 0; c < categoryNames.size(); ++c)
+        if (!categoryMembers[c].empty())
+            cats.push_back(c);
+    return cats;
+}
+
+// Read-only view of a list of products, used for catalog browsing without copying
+// Refers to every product, to a slot list kept by an index, or to a small list it owns
+// A view is only valid until the store changes
+struct CatalogView {
+    bool all = false;
+    bool reversed = false; // Read the list back to front
+    const vector<int>* shared = nullptr;
+    vector<int> own;
+
+    size_t size() const { return all ? products.size() : shared ? shared->size() : own.size(); }
+    bool empty() const { return size() == 0; }
+    // Index in products of the i-th product in the view
+    int operator[](size_t i) const {
+        if (reversed) i = size() - 1 - i;
+        return all ? (int)i : shared ? (*shared)[i] : own[i];
+    }
+    // Handle to the i-th product in the view, which stays checkable after the view is gone
+    ProductHandle handleAt(size_t i) const { return handleOf((*this)[i]); }
+};
+
+// Live slots of a list of products, in the same order
+vector<int> liveSlots(const vector<int>& slots) {
+    vector<int> result;
+    result.reserve(slots.size());
+    for (int slot : slots)
+        if (products.isLive(slot)) result.push_back(slot);
+    return result;
+}
+
+// View of every product
+CatalogView viewAllProducts() {
+    CatalogView v;
+    if (products.tombstones == 0) {
+        v.all = true;
+        return v;
+    }
+    for (size_t i = 0; i < products.size(); ++i)
+        if (products.isLive(i)) v.own.push_back(i);
+    return v;
+}
+
+// View of the products in a category
+CatalogView viewCategory(int categoryId) {
+    CatalogView v;
+    v.shared = &categoryMembers[categoryId];
+    return v;
+}
+
+// View of an explicit list of products
+CatalogView viewSlots(vector<int> slots) {
+    CatalogView v;
+    v.own = move(slots);
+    return v;
+}
+
+// Price index: every product's slot, sorted by ascending price (ties by slot)
+// Tombstones stay in it until the next compaction and are skipped when it is read
+vector<int> productPriceIndex;
+
+// Ordering used by the price index
+bool cheaperThan(int a, int b) {
+    if (products[a].price != products[b].price) return products[a].price < products[b].price;
+    return a < b;
+}
+
+// View of every product sorted by price
+CatalogView viewByPrice(bool descending) {
+    CatalogView v;
+    if (products.tombstones == 0)
+        v.shared = &productPriceIndex;
+    else
+        v.own = liveSlots(productPriceIndex);
+    v.reversed = descending;
+    return v;
+}
+
+// Return the products priced between 'low' and 'high' pesos (inclusive), cheapest first
+vector<int> productsInPriceRange(Money low, Money high) {
+    auto first = lower_bound(productPriceIndex.begin(), productPriceIndex.end(), low,
+                             [](int slot, Money v) { return products[slot].price < v; });
+    auto last = upper_bound(first, productPriceIndex.end(), high,
+                            [](Money v, int slot) { return v < products[slot].price; });
+    vector<int> result;
+    for (; first != last; ++first)
+        if (products.isLive(*first)) result.push_back(*first);
+    return result;
+}
+
+// Return the 'n' cheapest products in a category, cheapest first
+// Sorts only that category's members, so the cost depends on the category size
+vector<int> cheapestInCategory(int categoryId, size_t n) {
+    const vector<int>& members = categoryMembers[categoryId];
+    vector<int> result(min(n, members.size()));
+    partial_sort_copy(members.begin(), members.end(), result.begin(), result.end(), cheaperThan);
+    return result;
+}
+
+// Products at or below this quantity are flagged for reordering
+const int REORDER_LEVEL = 5;
+
+// Low-stock heap: an indexed binary min-heap of slots ordered by quantity, so the most
+// critical products are found without a scan and a stock change is repaired in O(log n)
+vector<int> stockHeap;    // Heap of indices in products
+vector<int> stockHeapPos; // Index in products -> position in stockHeap
+
+// Ordering used by the low-stock heap
+bool lowerStock(int a, int b) {
+    if (products[a].quantity != products[b].quantity) return products[a].quantity < products[b].quantity;
+    return a < b;
+}
+
+// Swap two heap entries and update their positions
+void stockHeapSwap(size_t i, size_t j) {
+    swap(stockHeap[i], stockHeap[j]);
+    stockHeapPos[stockHeap[i]] = i;
+    stockHeapPos[stockHeap[j]] = j;
+}
+
+void stockHeapSiftUp(size_t i) {
+    while (i > 0 && lowerStock(stockHeap[i], stockHeap[(i - 1) / 2])) {
+        stockHeapSwap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+void stockHeapSiftDown(size_t i) {
+    while (true) {
+        size_t smallest = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < stockHeap.size() && lowerStock(stockHeap[l], stockHeap[smallest])) smallest = l;
+        if (r < stockHeap.size() && lowerStock(stockHeap[r], stockHeap[smallest])) smallest = r;
+        if (smallest == i) return;
+        stockHeapSwap(i, smallest);
+        i = smallest;
+    }
+}
+
+// Add the product at 'slot' to the low-stock heap
+void stockHeapInsert(int slot) {
+    if (stockHeapPos.size() <= (size_t)slot) stockHeapPos.resize(slot + 1);
+    stockHeap.push_back(slot);
+    stockHeapPos[slot] = stockHeap.size() - 1;
+    stockHeapSiftUp(stockHeap.size() - 1);
+}
+
+// Restore the heap order after the quantity of the product at 'slot' changed
+void stockHeapUpdate(int slot) {
+    stockHeapSiftUp(stockHeapPos[slot]);
+    stockHeapSiftDown(stockHeapPos[slot]);
+}
+
+// Take the product at 'slot' out of the low-stock heap
+void stockHeapRemove(int slot) {
+    size_t i = stockHeapPos[slot];
+    stockHeapSwap(i, stockHeap.size() - 1);
+    stockHeap.pop_back();
+    if (i < stockHeap.size()) {
+        stockHeapSiftUp(i);
+        stockHeapSiftDown(stockHeapPos[stockHeap[i]]);
+    }
+}
+
+// Build the low-stock heap from every product
+void rebuildStockHeap() {
+    stockHeap.resize(products.size());
+    stockHeapPos.resize(products.size());
+    for (size_t i = 0; i < products.size(); ++i) stockHeap[i] = stockHeapPos[i] = i;
+    for (size_t i = stockHeap.size() / 2; i-- > 0;) stockHeapSiftDown(i);
+}
+
+// Return the 'n' products with the lowest stock, lowest first, without changing the heap
+// Explores the heap best-first, so the cost is O(n log n) regardless of catalog size
+vector<int> lowestStock(size_t n) {
+    vector<int> result;
+    auto later = [](size_t a, size_t b) { return lowerStock(stockHeap[b], stockHeap[a]); };
+    priority_queue<size_t, vector<size_t>, decltype(later)> frontier(later);
+    if (!stockHeap.empty()) frontier.push(0);
+    while (!frontier.empty() && result.size() < n) {
+        size_t i = frontier.top();
+        frontier.pop();
+        result.push_back(stockHeap[i]);
+        if (2 * i + 1 < stockHeap.size()) frontier.push(2 * i + 1);
+        if (2 * i + 2 < stockHeap.size()) frontier.push(2 * i + 2);
+    }
+    return result;
+}
+
+// Count the products at or below REORDER_LEVEL (visits only those products)
+size_t countReorderNeeded() {
+    size_t count = 0;
+    vector<size_t> stack;
+    if (!stockHeap.empty()) stack.push_back(0);
+    while (!stack.empty()) {
+        size_t i = stack.back();
+        stack.pop_back();
+        if (products[stockHeap[i]].quantity > REORDER_LEVEL) continue;
+        count++;
+        if (2 * i + 1 < stockHeap.size()) stack.push_back(2 * i + 1);
+        if (2 * i + 2 < stockHeap.size()) stack.push_back(2 * i + 2);
+    }
+    return count;
+}
+
+// Totals over a set of products: value of the stock on hand, units on hand, and products needing reorder
+struct StockTotals {
+    Money value;
+    long long units = 0;
+    size_t reorder = 0;
+    bool overflow = false; // The value did not fit; 'value' then holds the largest amount
+
+    // Add to the value, saturating instead of wrapping around
+    void addValue(Money m) {
+        if (!addMoney(value, m)) {
+            value = Money::fromCentavos(numeric_limits<int64_t>::max());
+            overflow = true;
+        }
+    }
+    // Add totals computed over another set of products
+    void merge(const StockTotals& o) {
+        addValue(o.value);
+        overflow = overflow || o.overflow;
+        units += o.units;
+        reorder += o.reorder;
+    }
+};
+
+// Stock totals kernel: over products [0, n) of the columns, or over slots[0, n) when 'slots' is given
+typedef StockTotals (*StockTotalsKernel)(const int* qty, const Money* price, const int* slots, size_t n);
+
+StockTotals stockTotalsScalar(const int* qty, const Money* price, const int* slots, size_t n) {
+    StockTotals t;
+    for (size_t i = 0; i < n; ++i) {
+        size_t s = slots ? slots[i] : i;
+        t.addValue(price[s] * qty[s]);
+        t.units += qty[s];
+        t.reorder += qty[s] <= REORDER_LEVEL;
+    }
+    return t;
+}
+
+#ifdef HAVE_X86_SIMD
+// Add up 4 products with AVX2 (gathering them when 'slots' is given)
+__attribute__((target("avx2")))
+inline void addStock4(const int* qty, const Money* price, const int* slots, size_t i,
+                      __m256i& value, __m256i& units, __m128i& reorder) {
+    const long long* cents = reinterpret_cast<const long long*>(price); // Money is a bare int64
+    __m128i q;
+    __m256i p;
+    if (slots) {
+        __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(slots + i));
+        // Masked forms with a zero source: same gathers, without reading an undefined register
+        q = _mm_mask_i32gather_epi32(_mm_setzero_si128(), qty, idx, _mm_set1_epi32(-1), sizeof(int));
+        p = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), cents, idx, _mm256_set1_epi64x(-1), sizeof(Money));
+    } else {
+        q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(qty + i));
+        p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cents + i));
+    }
+    // 64-bit products from 32-bit multiplies: lo*lo + ((hi*lo + lo*hi) << 32), exact mod 2^64
+    __m256i q64 = _mm256_cvtepi32_epi64(q);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(p, 32), q64),
+                                     _mm256_mul_epu32(p, _mm256_srli_epi64(q64, 32)));
+    value = _mm256_add_epi64(value, _mm256_add_epi64(_mm256_mul_epu32(p, q64), _mm256_slli_epi64(cross, 32)));
+    units = _mm256_add_epi64(units, q64);
+    // Each lane counts down by one (the all-ones compare mask) for every product at or below the level
+    reorder = _mm_add_epi32(reorder, _mm_cmplt_epi32(q, _mm_set1_epi32(REORDER_LEVEL + 1)));
+}
+
+// Products per block of the AVX2 kernel: each value lane adds 256 products below 2^54, so it
+// cannot wrap before the block is folded into the checked total
+const size_t STOCK_TOTALS_BLOCK = 2048;
+
+// 8 products per iteration in two independent accumulator sets
+__attribute__((target("avx2")))
+StockTotals stockTotalsAvx2(const int* qty, const Money* price, const int* slots, size_t n) {
+    StockTotals t;
+    __m256i units[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+    __m128i reorder[2] = {_mm_setzero_si128(), _mm_setzero_si128()};
+    size_t full = n - n % 8;
+    for (size_t block = 0; block < full; block += STOCK_TOTALS_BLOCK) {
+        __m256i value[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+        size_t end = min(full, block + STOCK_TOTALS_BLOCK);
+        for (size_t i = block; i < end; i += 8) {
+            addStock4(qty, price, slots, i, value[0], units[0], reorder[0]);
+            addStock4(qty, price, slots, i + 4, value[1], units[1], reorder[1]);
+        }
+        alignas(32) long long v[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(v), value[0]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(v + 4), value[1]);
+        for (long long lane : v) t.addValue(Money::fromCentavos(lane));
+    }
+    alignas(32) long long u[4];
+    alignas(16) int r[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(u), _mm256_add_epi64(units[0], units[1]));
+    _mm_store_si128(reinterpret_cast<__m128i*>(r), _mm_add_epi32(reorder[0], reorder[1]));
+    _mm256_zeroupper(); // Avoid the AVX-to-SSE transition penalty in the scalar tail
+    t.merge(slots ? stockTotalsScalar(qty, price, slots + full, n - full)
+                  : stockTotalsScalar(qty + full, price + full, nullptr, n - full));
+    t.units += u[0] + u[1] + u[2] + u[3];
+    t.reorder -= (long long)r[0] + r[1] + r[2] + r[3];
+    return t;
+}
+#endif
+
+// Pick the fastest kernel the CPU supports
+StockTotalsKernel selectStockTotalsKernel() {
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return stockTotalsAvx2;
+#endif
+    return stockTotalsScalar;
+}
+
+StockTotalsKernel stockTotalsKernel = selectStockTotalsKernel();
+
+// Totals over every product
+// Tombstones have quantity 0, so they only need taking back out of the reorder count
+StockTotals stockTotals() {
+    StockTotals t = stockTotalsKernel(products.quantity.data(), products.price.data(), nullptr, products.size());
+    t.reorder -= products.tombstones;
+    return t;
+}
+
+// Totals over the products in a category
+StockTotals categoryStockTotals(int categoryId) {
+    const vector<int>& members = categoryMembers[categoryId];
+    return stockTotalsKernel(products.quantity.data(), products.price.data(), members.data(), members.size());
+}
+
+// Product ID high-water mark: every ID below it is used or reserved by some admin session
+int nextProductId = 1;
+
+// Indexes over the products vector, kept in sync by the store functions below
+unordered_map<int, int> productIdIndex;                   // Product ID -> index in products
+unordered_map<string, vector<int>> productNameIndex;      // nameKey(name) -> indices in products
+unordered_map<uint32_t, vector<int>> productTrigramIndex; // Name trigram -> ascending indices in products
+
+// Add the product at 'slot' to the indexes
+// Slots are added in increasing order, so posting lists stay sorted
+void indexProduct(int slot) {
+    stampSlot(slot);
+    categoryMembers[products.categoryId[slot]].push_back(slot);
+    productIdIndex[products[slot].id] = slot;
+    productNameIndex[nameKey(products[slot].name)].push_back(slot);
+    for (uint32_t gram : trigramsOf(lowercase(products[slot].name)))
+        productTrigramIndex[gram].push_back(slot);
+    trieInsert(nameKey(products[slot].name), slot);
+}
+
+// Add the product at 'slot' to the price index, keeping it sorted
+void indexProductPrice(int slot) {
+    productPriceIndex.insert(upper_bound(productPriceIndex.begin(), productPriceIndex.end(), slot, cheaperThan), slot);
+}
+
+// Rebuild every index from the products vector (after a load or a compaction)
+// The store must hold no tombstones
+void rebuildIndexes() {
+    productIdIndex.clear();
+    productIdIndex.reserve(products.size());
+    productNameIndex.clear();
+    productNameIndex.reserve(products.size());
+    productTrigramIndex.clear();
+    nameTrie.assign(1, NameTrieNode());
+    freeTrieNodes.clear();
+    categoryMembers.assign(categoryNames.size(), vector<int>());
+    for (size_t i = 0; i < products.size(); ++i)
+        indexProduct(i);
+    // Sorting once is cheaper than inserting every product into the price index in turn
+    productPriceIndex.resize(products.size());
+    for (size_t i = 0; i < products.size(); ++i) productPriceIndex[i] = i;
+    sort(productPriceIndex.begin(), productPriceIndex.end(), cheaperThan);
+    rebuildStockHeap();
+}
+
+// Append a product to the store and index it
+void addProductToStore(const Product& p) {
+    nextProductId = max(nextProductId, p.id + 1);
+    products.push_back(p);
+    indexProduct(products.size() - 1);
+    indexProductPrice(products.size() - 1);
+    stockHeapInsert(products.size() - 1);
+}
+
+// Add 'delta' to the stock of the product at 'slot' (negative to remove stock)
+void changeStock(int slot, int delta) {
+    products[slot].quantity += delta;
+    stockHeapUpdate(slot);
+}
+
+// Never compact below this many tombstones, so small catalogs are not rebuilt constantly
+const size_t COMPACT_MIN_TOMBSTONES = 1000;
+// Compact once tombstones make up more than this share of the slots
+const double COMPACT_TOMBSTONE_RATIO = 0.25;
+
+// Squeeze the tombstones out of the store and remap every index in one sweep
+void compactProducts() {
+    products.compact();
+    rebuildIndexes();
+}
+
+// Remove the product at 'slot' from the store
+// The slot becomes a tombstone and no other product moves: the ID, name, trie, category and
+// low-stock indexes drop it now, while the trigram and price indexes and the name arena skip
+// it when read until the tombstone share calls for a compaction
+void removeProductFromStore(int slot) {
+    ProductRef p = products[slot];
+    string key = nameKey(p.name);
+    productIdIndex.erase(p.id);
+    auto named = productNameIndex.find(key);
+    if (named != productNameIndex.end()) {
+        named->second.erase(remove(named->second.begin(), named->second.end(), slot), named->second.end());
+        if (named->second.empty()) productNameIndex.erase(named);
+    }
+    trieRemove(key, slot);
+    vector<int>& members = categoryMembers[p.categoryId];
+    members.erase(lower_bound(members.begin(), members.end(), slot));
+    stockHeapRemove(slot);
+    stampSlot(slot); // Handles to the removed product go stale
+    products.tombstone(slot);
+    if (products.tombstones >= COMPACT_MIN_TOMBSTONES
+        && products.tombstones > products.size() * COMPACT_TOMBSTONE_RATIO)
+        compactProducts();
+}
+
+// Find the index of a product by ID (-1 if not found)
+int findProductIndexByID(int id) {
+    auto it = productIdIndex.find(id);
+    return it == productIdIndex.end() ? -1 : it->second;
+}
+
+// Check if a string contains only digits
+bool isDigits(const string& s) {
+    if (s.empty()) return false;
+    for (char c : s)
+        if (!isdigit(static_cast<unsigned char>(c)))
+            return false;
+    return true;
+}
+
+// Check if a string contains at least one alphabet letter
+bool containsLetter(const string& s) {
+    for (char c : s)
+        if (isalpha(static_cast<unsigned char>(c)))
+            return true;
+    return false;
+}
+
+// Check if a string is a valid positive double (float) number
+bool isValidDouble(const string& s) {
+    bool decimalPoint = false;
+    int count = 0;
+    for (char c : s) {
+        if (c == '.') {
+            if (decimalPoint) return false;
+            decimalPoint = true;
+            continue;
+        }
+        if (!isdigit(static_cast<unsigned char>(c))) return false;
+        count++;
+    }
+    return count > 0;
+}
+
+// Storage files: the binary catalog snapshot, the journal of changes made since it was written,
+// and the pipe-delimited text file used to import and export the catalog
+const string CATALOG_FILE  = "products.bin";
+const string JOURNAL_FILE  = "products.journal";
+const string PRODUCTS_FILE = "products.txt";
+
+// Never checkpoint before this many journal records, so small catalogs are not rewritten constantly
+const size_t JOURNAL_MIN_CHECKPOINT = 1000;
+
+// Binary catalog layout (native byte order):
+//   CatalogHeader (version 1 files end the header before nextId)
+//   int32  id[count]
+//   int32  quantity[count]
+//   int64  price[count] in centavos (double pesos before version 3)
+//   uint32 nameOffset[count], nameLength[count]
+//   uint32 categoryOffset[count], categoryLength[count]
+//   string table (stringBytes bytes; products in one category share its bytes)
+const char CATALOG_MAGIC[4] = {'Y', 'X', 'P', 'C'};
+const uint32_t CATALOG_VERSION = 3;
+
+struct CatalogHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t generation;   // Incremented on every save
+    uint64_t count;        // Number of product records
+    uint64_t stringBytes;  // Size of the string table
+    uint64_t nextId;       // Product ID high-water mark: no ID at or above it was ever handed out
+};
+
+// Identity and version of a storage file, used to tell whether it changed since it was read
+struct FileStamp {
+    bool exists = false;
+    unsigned long long device = 0, inode = 0, size = 0;
+    long long mtimeSec = 0, mtimeNsec = 0;
+
+    bool operator==(const FileStamp& o) const {
+        return exists == o.exists && device == o.device && inode == o.inode && size == o.size
+            && mtimeSec == o.mtimeSec && mtimeNsec == o.mtimeNsec;
+    }
+    bool operator!=(const FileStamp& o) const { return !(*this == o); }
 };
 
-vector<Product> products;
+// Read the current stamp of a file (exists == false if it is missing)
+FileStamp fileStamp(const string& filename) {
+    FileStamp fs;
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) return fs;
+    fs.exists = true;
+    fs.device = st.st_dev;
+    fs.inode = st.st_ino;
+    fs.size = st.st_size;
+    fs.mtimeSec = st.st_mtime;
+#if defined(__APPLE__)
+    fs.mtimeNsec = st.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+    fs.mtimeNsec = st.st_mtim.tv_nsec;
+#endif
+    return fs;
+}
+
+// Stamps of the storage files as of the last load or write by this program
+bool catalogLoaded = false;
+FileStamp catalogStamp, journalStamp, productsTextStamp;
+
+// Remember the current state of the storage files as already reflected in memory
+void recordStorageStamps() {
+    catalogStamp = fileStamp(CATALOG_FILE);
+    journalStamp = fileStamp(JOURNAL_FILE);
+    productsTextStamp = fileStamp(PRODUCTS_FILE);
+    catalogLoaded = true;
+}
+
+// True if no storage file changed since the catalog was loaded or last written
+bool storageUnchanged() {
+    if (!catalogLoaded) return false;
+    FileStamp catalog = fileStamp(CATALOG_FILE);
+    if (catalog != catalogStamp || fileStamp(JOURNAL_FILE) != journalStamp) return false;
+    // products.txt is only read when there is no binary catalog
+    return catalog.exists || fileStamp(PRODUCTS_FILE) == productsTextStamp;
+}
+
+// Open a file for writing (truncating it, or appending to it); returns -1 on failure
+int openForWrite(const string& filename, bool append) {
+#ifdef _WIN32
+    int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC);
+    return _open(filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+    int flags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+    return open(filename.c_str(), flags, 0644);
+#endif
+}
+
+// Write all bytes to a file descriptor
+bool writeAll(int fd, string_view data) {
+    while (!data.empty()) {
+#ifdef _WIN32
+        int n = _write(fd, data.data(), static_cast<unsigned>(min<size_t>(data.size(), 1 << 30)));
+#else
+        ssize_t n = ::write(fd, data.data(), data.size());
+#endif
+        if (n <= 0) return false;
+        data.remove_prefix(n);
+    }
+    return true;
+}
+
+// Flush a file descriptor to stable storage and close it
+bool syncAndClose(int fd) {
+#ifdef _WIN32
+    bool ok = _commit(fd) == 0;
+    return _close(fd) == 0 && ok;
+#else
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+#endif
+}
+
+// Replace 'filename' with new contents so that a crash leaves either the old or the new file:
+// write a temp file, flush it, rename it over the original, then flush the directory entry
+bool writeFileAtomic(const string& filename, string_view data) {
+    string tmp = filename + ".tmp";
+    int fd = openForWrite(tmp, false);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, data);
+    ok = syncAndClose(fd) && ok;
+    if (!ok) {
+        remove(tmp.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    remove(filename.c_str()); // rename() does not replace an existing file on Windows
+#endif
+    if (rename(tmp.c_str(), filename.c_str()) != 0) return false;
+#ifndef _WIN32
+    int dirfd = open(".", O_RDONLY);
+    if (dirfd >= 0) {
+        fsync(dirfd);
+        close(dirfd);
+    }
+#endif
+    return true;
+}
+
+// Exclusive lock shared by every session using these files (no-op on Windows)
+// Held while reserving product IDs so two sessions never reserve the same block, while writing
+// a snapshot, and while appending to the journal, so no session's journal records are lost
+// The lock belongs to the whole program: nested or concurrent holders in this session share it
+struct StorageLock {
+    static mutex guard;
+    static int holders;
+    static int fd;
+    StorageLock() {
+        lock_guard<mutex> lock(guard);
+        if (holders++ > 0) return;
+#ifndef _WIN32
+        fd = open("products.lock", O_RDWR | O_CREAT, 0644);
+        if (fd >= 0) flock(fd, LOCK_EX);
+#endif
+    }
+    ~StorageLock() {
+        lock_guard<mutex> lock(guard);
+        if (--holders > 0) return;
+#ifndef _WIN32
+        if (fd >= 0) {
+            flock(fd, LOCK_UN);
+            close(fd);
+        }
+#endif
+        fd = -1;
+    }
+    StorageLock(const StorageLock&) = delete;
+    StorageLock& operator=(const StorageLock&) = delete;
+};
+mutex StorageLock::guard;
+int StorageLock::holders = 0;
+int StorageLock::fd = -1;
+
+// Group commit: journal records are queued and a background thread writes everything that
+// arrives within GROUP_COMMIT_WINDOW_MS with a single write and a single fsync
+const int GROUP_COMMIT_WINDOW_MS = 5;
+
+mutex journalMutex;
+condition_variable journalQueued;    // Signalled when records are queued or the flusher must stop
+condition_variable journalCommitted; // Signalled after each durable batch
+string pendingJournal;               // Records queued but not yet written
+uint64_t journalQueuedSeq = 0;       // Number of appends queued so far
+uint64_t journalDurableSeq = 0;      // Number of appends flushed to stable storage (or failed)
+bool journalWriteFailed = false;     // A batch could not be written since the last waitForCommit()
+bool journalFlusherStop = false;
+thread journalFlusher;
+
+// Append records to the journal file and flush them, holding the storage lock so no other
+// session appends or checkpoints in between; 'before' and 'after' receive the file's stamps
+bool writeJournalBatch(string_view batch, FileStamp& before, FileStamp& after) {
+    StorageLock storage;
+    before = fileStamp(JOURNAL_FILE);
+    int fd = openForWrite(JOURNAL_FILE, true);
+    bool ok = fd >= 0 && writeAll(fd, batch);
+    if (fd >= 0) ok = syncAndClose(fd) && ok;
+    after = fileStamp(JOURNAL_FILE);
+    if (!ok) cerr << "Warning: could not write " << JOURNAL_FILE << ".\n";
+    return ok;
+}
+
+// Background thread that turns queued journal records into durable batches
+void journalFlusherLoop() {
+    unique_lock<mutex> lock(journalMutex);
+    while (true) {
+        journalQueued.wait(lock, [] { return !pendingJournal.empty() || journalFlusherStop; });
+        if (pendingJournal.empty()) break;
+        // Let mutations arriving within the window join this batch
+        journalQueued.wait_for(lock, chrono::milliseconds(GROUP_COMMIT_WINDOW_MS),
+                               [] { return journalFlusherStop; });
+        string batch;
+        batch.swap(pendingJournal);
+        uint64_t batchSeq = journalQueuedSeq;
+        lock.unlock();
+
+        FileStamp before, after;
+        bool ok = writeJournalBatch(batch, before, after);
+
+        lock.lock();
+        if (!ok) journalWriteFailed = true;
+        // Only treat the file as ours if nobody else changed it since we last looked
+        if (before == journalStamp) journalStamp = after;
+        journalDurableSeq = batchSeq;
+        journalCommitted.notify_all();
+    }
+}
+
+// Stops the flusher at program exit after writing everything still queued
+struct JournalFlusherShutdown {
+    ~JournalFlusherShutdown() {
+        {
+            lock_guard<mutex> lock(journalMutex);
+            journalFlusherStop = true;
+        }
+        journalQueued.notify_all();
+        if (journalFlusher.joinable()) journalFlusher.join();
+    }
+} journalFlusherShutdown;
+
+// Block until every journal record queued so far has been written
+// Returns false if a batch failed since the last waitForCommit(), leaving the failure pending
+bool waitForFlush() {
+    unique_lock<mutex> lock(journalMutex);
+    uint64_t seq = journalQueuedSeq;
+    journalCommitted.wait(lock, [seq] { return journalDurableSeq >= seq; });
+    return !journalWriteFailed;
+}
+
+// Block until every journal record queued so far is on stable storage
+// Returns false, once, if any record queued since the last call could not be made durable;
+// the next loadProducts() then reloads the catalog from the files, dropping the unsaved changes,
+// so callers reporting the failure call it before carrying on
+bool waitForCommit() {
+    unique_lock<mutex> lock(journalMutex);
+    uint64_t seq = journalQueuedSeq;
+    journalCommitted.wait(lock, [seq] { return journalDurableSeq >= seq; });
+    if (!journalWriteFailed) return true;
+    journalWriteFailed = false;
+    catalogLoaded = false;
+    return false;
+}
+
+uint64_t catalogGeneration = 0; // Generation of the binary snapshot the catalog was built from
+string snapshotTag;             // Identifies the snapshot the in-memory catalog was built from
+bool journalMatchesSnapshot;    // True if the journal on disk was written against snapshotTag
+size_t journalRecords = 0;      // Number of records in the journal since the last checkpoint
+bool catalogDamaged = false;    // products.bin exists but cannot be read: nothing may be written
+bool checkpointDeferred = false; // Another session wrote since the last load: checkpoint after the next one
+
+// Compute a 64-bit FNV-1a hash of a buffer, returned as hex text
+string hashBytes(string_view data) {
+    unsigned long long h = 14695981039346656037ULL;
+    for (char c : data) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    stringstream ss;
+    ss << hex << h;
+    return ss.str();
+}
+
+// Read-only view of a whole file, memory-mapped where the platform supports it
+// An empty or missing file gives an empty view
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    string buffer;
+#endif
+
+    explicit MappedFile(const string& filename) {
+#ifdef _WIN32
+        ifstream fin(filename, ios::binary);
+        if (!fin) return;
+        stringstream ss;
+        ss << fin.rdbuf();
+        buffer = ss.str();
+        data = buffer.data();
+        size = buffer.size();
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data = static_cast<const char*>(addr);
+                size = st.st_size;
+                madvise(addr, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (data) munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    string_view view() const { return string_view(data, size); }
+};
+
+// Split the next line off 'rest' (without the newline or a trailing '\r')
+// 'terminated' is set to false if the line was not ended by a newline
+string_view nextLine(string_view& rest, bool& terminated) {
+    size_t pos = rest.find('\n');
+    terminated = pos != string_view::npos;
+    string_view line = rest.substr(0, pos);
+    rest = terminated ? rest.substr(pos + 1) : string_view();
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+// Split the next '|'-delimited field off 'rest'
+string_view nextField(string_view& rest) {
+    size_t pos = rest.find('|');
+    string_view field = rest.substr(0, pos);
+    rest = pos == string_view::npos ? string_view() : rest.substr(pos + 1);
+    return field;
+}
+
+// Parse a whole field as a number, without allocating
+template <typename T>
+bool parseNumber(string_view s, T& out) {
+    auto res = from_chars(s.data(), s.data() + s.size(), out);
+    return res.ec == errc() && res.ptr == s.data() + s.size();
+}
+
+// Parse a price field from products.txt or the journal
+// Files written before prices were exact used the default stream format, which prints
+// 1000000 pesos and above in exponent form ("1.5e+06"); those are converted through double
+bool parseStoredMoney(string_view s, Money& out) {
+    if (parseMoney(s, out, true)) return true;
+    if (s.empty() || s.size() > 32 || s.find_first_of("eE") == string_view::npos) return false;
+    char buf[33];
+    memcpy(buf, s.data(), s.size());
+    buf[s.size()] = '\0';
+    char* end;
+    double pesos = strtod(buf, &end);
+    if (end != buf + s.size() || !(pesos >= 0 && pesos * 100 <= MAX_PRICE_CENTAVOS)) return false;
+    out = Money::fromCentavos(llround(pesos * 100));
+    return true;
+}
+
+// Parse an "id|name|category|qty|price" record into a product
+bool parseProductRecord(string_view rest, Product& p) {
+    if (!parseNumber(nextField(rest), p.id)) return false;
+    p.name.assign(nextField(rest));
+    p.category.assign(nextField(rest));
+    if (!parseNumber(nextField(rest), p.quantity) || p.quantity < 0 || p.quantity > MAX_QUANTITY) return false;
+    return parseStoredMoney(nextField(rest), p.price);
+}
+
+// Journal record for a newly added product
+string journalAddRecord(const Product& p) {
+    stringstream ss;
+    ss << "A|" << p.id << "|" << p.name << "|" << p.category << "|"
+       << p.quantity << "|" << p.price << "\n";
+    return ss.str();
+}
+
+// Journal record for a stock change (positive for stock in, negative for stock out)
+string journalStockRecord(int id, int delta) {
+    return "S|" + to_string(id) + "|" + to_string(delta) + "\n";
+}
+
+// Journal record for a deleted product
+string journalDeleteRecord(int id) {
+    return "D|" + to_string(id) + "\n";
+}
+
+// Move a journal that does not belong to the loaded snapshot out of the way, so the next
+// change does not overwrite it; returns the name it was given
+string setAsideJournal() {
+    string name = JOURNAL_FILE + ".stale";
+    for (int i = 1; fileStamp(name).exists; ++i) name = JOURNAL_FILE + ".stale" + to_string(i);
+    if (rename(JOURNAL_FILE.c_str(), name.c_str()) != 0) return "";
+    return name;
+}
+
+// Replay the journal on top of the snapshot already loaded into the products vector
+// Records are only applied if the journal was written against the loaded snapshot
+// A journal left by an interrupted checkpoint (one generation back) is already folded into the
+// snapshot and is dropped; any other mismatched journal with records is set aside with a warning
+void replayJournal() {
+    journalRecords = 0;
+    journalMatchesSnapshot = false;
+    MappedFile file(JOURNAL_FILE);
+    string_view rest = file.view();
+    bool terminated;
+    string_view header = nextLine(rest, terminated);
+    if (header != "J|" + snapshotTag || !terminated) {
+        bool interruptedCheckpoint = catalogGeneration > 0 && header == "J|g" + to_string(catalogGeneration - 1);
+        if (rest.empty() || interruptedCheckpoint) return;
+        string name = setAsideJournal();
+        cerr << "Warning: " << JOURNAL_FILE << " was written against a different catalog and was not applied.\n";
+        if (!name.empty()) cerr << "Its changes were kept in " << name << ".\n";
+        return;
+    }
+    journalMatchesSnapshot = true;
+    while (!rest.empty()) {
+        string_view record = nextLine(rest, terminated);
+        if (!terminated) break; // Last record has no newline: torn write, ignore it
+        string_view op = nextField(record);
+        if (op == "A") {
+            Product p;
+            if (!parseProductRecord(record, p) || findProductIndexByID(p.id) != -1) continue;
+            addProductToStore(p);
+        } else if (op == "S") {
+            int id, delta;
+            if (!parseNumber(nextField(record), id) || !parseNumber(nextField(record), delta)) continue;
+            int idx = findProductIndexByID(id);
+            if (idx == -1) continue;
+            changeStock(idx, delta);
+        } else if (op == "D") {
+            int id;
+            if (!parseNumber(nextField(record), id)) continue;
+            int idx = findProductIndexByID(id);
+            if (idx == -1) continue;
+            removeProductFromStore(idx);
+        } else if (op == "H") {
+            int highWater;
+            if (!parseNumber(nextField(record), highWater)) continue;
+            nextProductId = max(nextProductId, highWater);
+        } else {
+            continue;
+        }
+        journalRecords++;
+    }
+}
+
+// Text imports at least this large are parsed on all cores
+const size_t PARALLEL_PARSE_MIN_BYTES = 1 << 20;
 
-// Return a vector of unique category names from the products list
-vector<string> getCategories() {
-    vector<string> cats;
-    for (const auto& p : products) {
-        if (find(cats.begin(), cats.end(), p.category) == cats.end())
-            cats.push_back(p.category);
+// Parse pipe-delimited "id|name|category|qty|price" records into 'out', in file order
+// Malformed lines are skipped and counted in 'rejected'
+void parseProductRecords(string_view rest, vector<Product>& out, size_t& rejected) {
+    bool terminated;
+    while (!rest.empty()) {
+        string_view record = nextLine(rest, terminated);
+        if (record.empty()) continue;
+        out.emplace_back();
+        if (!parseProductRecord(record, out.back())) {
+            out.pop_back();
+            rejected++;
+        }
     }
-    return cats;
 }
 
-// Remove leading and trailing whitespace from a string
-string trim(const string& s) {
-    size_t first = s.find_first_not_of(" \t\r\n");
-    if (first == string::npos) return "";
-    size_t last = s.find_last_not_of(" \t\r\n");
-    return s.substr(first, last - first + 1);
+// Parse pipe-delimited text into the products vector
+// Large inputs are split on line boundaries and the chunks are parsed in parallel;
+// the results are appended in file order, keeping only the first product with each ID
+void parseProductsText(string_view text) {
+    size_t workers = text.size() >= PARALLEL_PARSE_MIN_BYTES ? thread::hardware_concurrency() : 1;
+    if (workers == 0) workers = 1;
+
+    vector<string_view> chunks;
+    while (!text.empty()) {
+        size_t cut = workers - chunks.size() <= 1 ? text.size() : text.size() / (workers - chunks.size());
+        cut = text.find('\n', cut == 0 ? 0 : cut - 1);
+        cut = cut == string_view::npos ? text.size() : cut + 1;
+        chunks.push_back(text.substr(0, cut));
+        text.remove_prefix(cut);
+    }
+
+    vector<vector<Product>> parsed(chunks.size());
+    vector<size_t> rejected(chunks.size(), 0);
+    if (chunks.size() == 1) {
+        parseProductRecords(chunks[0], parsed[0], rejected[0]);
+    } else {
+        vector<thread> threads;
+        for (size_t i = 0; i < chunks.size(); ++i)
+            threads.emplace_back(parseProductRecords, chunks[i], ref(parsed[i]), ref(rejected[i]));
+        for (auto& t : threads) t.join();
+    }
+
+    size_t total = products.size();
+    for (const auto& part : parsed) total += part.size();
+    products.reserve(total);
+    unordered_set<int> seen;
+    seen.reserve(total);
+    for (int id : products.id) seen.insert(id);
+    size_t duplicates = 0;
+    for (auto& part : parsed) {
+        for (auto& p : part) {
+            if (seen.insert(p.id).second)
+                products.push_back(move(p));
+            else
+                duplicates++;
+        }
+    }
+    if (duplicates > 0)
+        cerr << "Warning: skipped " << duplicates << " products with duplicate IDs.\n";
+    size_t malformed = 0;
+    for (size_t n : rejected) malformed += n;
+    if (malformed > 0)
+        cerr << "Warning: skipped " << malformed << " malformed lines in " << PRODUCTS_FILE << ".\n";
 }
 
-// Check if a string contains only digits
-bool isDigits(const string& s) {
-    if (s.empty()) return false;
-    for (char c : s)
-        if (!isdigit(static_cast<unsigned char>(c)))
+// Load the binary catalog snapshot into the products vector
+// Returns false if the file is missing or damaged (loadProducts tells the two apart)
+bool loadCatalogBinary() {
+    MappedFile file(CATALOG_FILE);
+    CatalogHeader h = {};
+    if (file.size < offsetof(CatalogHeader, nextId)) return false;
+    memcpy(&h, file.data, offsetof(CatalogHeader, nextId));
+    if (memcmp(h.magic, CATALOG_MAGIC, 4) != 0 || h.version < 1 || h.version > CATALOG_VERSION) return false;
+    size_t headerBytes = h.version == 1 ? offsetof(CatalogHeader, nextId) : sizeof(h);
+    if (file.size < headerBytes) return false;
+    memcpy(&h, file.data, headerBytes);
+    const uint64_t recordBytes = 2 * sizeof(int32_t) + sizeof(int64_t) + 4 * sizeof(uint32_t);
+    if (h.count > (file.size - headerBytes) / recordBytes
+        || file.size != headerBytes + h.count * recordBytes + h.stringBytes) return false;
+
+    size_t n = h.count;
+    const char* ids = file.data + headerBytes;
+    const char* qtys = ids + n * sizeof(int32_t);
+    const char* prices = qtys + n * sizeof(int32_t);
+    const char* spans = prices + n * sizeof(int64_t);
+    const char* strings = spans + n * 4 * sizeof(uint32_t);
+
+    // The numeric sections have the same layout as the store's columns
+    products.id.resize(n);
+    products.quantity.resize(n);
+    products.price.resize(n);
+    memcpy(products.id.data(), ids, n * sizeof(int32_t));
+    memcpy(products.quantity.data(), qtys, n * sizeof(int32_t));
+    if (h.version >= 3) {
+        memcpy(products.price.data(), prices, n * sizeof(int64_t));
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            double pesos;
+            memcpy(&pesos, prices + i * sizeof(double), sizeof(double));
+            products.price[i] = Money::fromCentavos(llround(pesos * 100));
+        }
+    }
+    products.categoryId.reserve(n);
+    products.nameOffset.reserve(n);
+    products.nameLength.reserve(n);
+    products.names.bytes.reserve(h.stringBytes + n);
+    products.live.assign(n, 1);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t span[4]; // name offset, name length, category offset, category length
+        for (int k = 0; k < 4; ++k)
+            memcpy(&span[k], spans + (k * n + i) * sizeof(uint32_t), sizeof(uint32_t));
+        if ((uint64_t)span[0] + span[1] > h.stringBytes || (uint64_t)span[2] + span[3] > h.stringBytes) {
+            products.clear();
             return false;
+        }
+        products.nameOffset.push_back(products.names.add(string_view(strings + span[0], span[1])));
+        products.nameLength.push_back(span[1]);
+        products.categoryId.push_back(internCategory(string_view(strings + span[2], span[3])));
+    }
+    catalogGeneration = h.generation;
+    snapshotTag = "g" + to_string(h.generation);
+    nextProductId = max<uint64_t>(h.nextId, 1);
     return true;
 }
 
-// Check if a string contains at least one alphabet letter
-bool containsLetter(const string& s) {
-    for (char c : s)
-        if (isalpha(static_cast<unsigned char>(c)))
-            return true;
-    return false;
+// Append the entries of a store column to 'data', leaving out tombstones
+template <typename T>
+void appendLiveColumn(string& data, const vector<T>& column) {
+    if (products.tombstones == 0) {
+        data.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+        return;
+    }
+    for (size_t i = 0; i < column.size(); ++i)
+        if (products.isLive(i)) data.append(reinterpret_cast<const char*>(&column[i]), sizeof(T));
 }
 
-// Check if a string is a valid positive double (float) number
-bool isValidDouble(const string& s) {
-    bool decimalPoint = false;
-    int count = 0;
-    for (char c : s) {
-        if (c == '.') {
-            if (decimalPoint) return false;
-            decimalPoint = true;
-            continue;
+// Write the whole catalog as a new binary snapshot and start an empty journal against it
+// Both files are replaced atomically; if a crash hits in between, the old journal names the
+// previous generation and is ignored on the next load
+void saveProducts() {
+    waitForFlush(); // Queued records must land in the journal they were written against
+    if (catalogDamaged) return; // Never overwrite a snapshot that could not be read
+
+    CatalogHeader h;
+    memcpy(h.magic, CATALOG_MAGIC, 4);
+    h.version = CATALOG_VERSION;
+    h.generation = catalogGeneration + 1;
+    h.count = products.liveCount();
+    h.nextId = nextProductId;
+
+    // Each category name is written once and shared by the spans of its products
+    // Tombstones are left out; the slots in memory stay as they are
+    size_t n = products.liveCount();
+    vector<uint32_t> spans(4 * n);
+    vector<int64_t> categoryOffset(categoryNames.size(), -1);
+    string strings;
+    for (size_t slot = 0, i = 0; slot < products.size(); ++slot) {
+        if (!products.isLive(slot)) continue;
+        ProductRef p = products[slot];
+        spans[i] = strings.size();
+        spans[n + i] = p.name.size();
+        strings += p.name;
+        if (categoryOffset[p.categoryId] < 0) {
+            categoryOffset[p.categoryId] = strings.size();
+            strings += p.category;
         }
-        if (!isdigit(static_cast<unsigned char>(c))) return false;
-        count++;
+        spans[2 * n + i] = categoryOffset[p.categoryId];
+        spans[3 * n + i] = p.category.size();
+        i++;
     }
-    return count > 0;
-}
+    h.stringBytes = strings.size();
+
+    string data;
+    data.reserve(sizeof(h) + n * (2 * sizeof(int32_t) + sizeof(int64_t)) + spans.size() * sizeof(uint32_t) + strings.size());
+    data.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    appendLiveColumn(data, products.id);
+    appendLiveColumn(data, products.quantity);
+    appendLiveColumn(data, products.price);
+    data.append(reinterpret_cast<const char*>(spans.data()), spans.size() * sizeof(uint32_t));
+    data.append(strings);
+    if (!writeFileAtomic(CATALOG_FILE, data)) {
+        cerr << "Warning: could not write " << CATALOG_FILE << ".\n";
+        return;
+    }
+    catalogGeneration = h.generation;
+    snapshotTag = "g" + to_string(h.generation);
 
-// Get the next available product ID
-int getNextID() {
-    int maxID = 0;
-    for (const auto& p : products)
-        if (p.id > maxID) maxID = p.id;
-    return maxID + 1;
+    lock_guard<mutex> lock(journalMutex);
+    journalMatchesSnapshot = writeFileAtomic(JOURNAL_FILE, "J|" + snapshotTag + "\n");
+    journalRecords = 0;
+    recordStorageStamps();
 }
 
-// Load products from a file into the products vector
-void loadProducts(const string& filename) {
+// Load the catalog snapshot and replay the journal into the products vector
+// The binary catalog is used when present; otherwise products.txt is imported
+// A products.bin that exists but cannot be read leaves the catalog empty and sets catalogDamaged,
+// rather than serving a possibly older products.txt and discarding the journal written against it
+// Does nothing if the storage files have not changed since the last load or write
+void loadProducts() {
+    // The files must hold everything already applied in memory; if some of it could not be
+    // written, the catalog in memory no longer matches them and is reloaded
+    if (!waitForFlush()) catalogLoaded = false;
+    if (storageUnchanged()) return;
     products.clear();
-    ifstream fin(filename);
-    if (!fin) return;
-    Product p;
-    string idstr;
-    while (getline(fin, idstr, '|')) {
-        p.id = stoi(idstr);
-        getline(fin, p.name, '|');
-        getline(fin, p.category, '|');
-        fin >> p.quantity;
-        fin.ignore(1, '|');
-        fin >> p.price;
-        fin.ignore(1, '\n');
-        products.push_back(p);
+    catalogDamaged = false;
+    bool haveSnapshot = loadCatalogBinary();
+    if (!haveSnapshot && fileStamp(CATALOG_FILE).exists) {
+        products.clear();
+        catalogDamaged = true;
+        cerr << "Error: " << CATALOG_FILE << " is damaged or was written by a newer version.\n"
+             << "No changes will be saved until it is restored or removed.\n";
+        rebuildIndexes();
+        recordStorageStamps();
+        return;
+    }
+    if (!haveSnapshot) {
+        MappedFile file(PRODUCTS_FILE);
+        catalogGeneration = 0;
+        snapshotTag = hashBytes(file.view());
+        nextProductId = 1;
+        parseProductsText(file.view());
+    }
+    for (int id : products.id) nextProductId = max(nextProductId, id + 1); // Text and version 1 files have no high-water mark
+    rebuildIndexes();
+    replayJournal();
+    recordStorageStamps();
+    checkpointDeferred = false;
+    if (!haveSnapshot) {
+        // Write products.bin right away, so the journal no longer refers to products.txt,
+        // which may still be edited by hand
+        StorageLock lock;
+        if (storageUnchanged()) saveProducts();
     }
-    fin.close();
 }
 
-// Save products from the products vector into a file
-void saveProducts(const string& filename) {
-    ofstream fout(filename);
-    for (const auto& p : products) {
-        fout << p.id << "|" << p.name << "|" << p.category << "|"
+// Write the catalog to products.txt in the pipe-delimited text format
+void exportProductsText() {
+    // While no binary catalog exists the journal refers to products.txt, so write one first
+    if (!fileStamp(CATALOG_FILE).exists) saveProducts();
+    stringstream data;
+    for (size_t i = 0; i < products.size(); ++i) {
+        if (!products.isLive(i)) continue;
+        ProductRef p = products[i];
+        data << p.id << "|" << p.name << "|" << p.category << "|"
              << p.quantity << "|" << p.price << "\n";
     }
-    fout.close();
+    if (!writeFileAtomic(PRODUCTS_FILE, data.str()))
+        cerr << "Warning: could not write " << PRODUCTS_FILE << ".\n";
+    productsTextStamp = fileStamp(PRODUCTS_FILE);
+}
+
+// Fold the journal into a new snapshot, holding the storage lock
+// Only done if no other session wrote since this one last loaded, so their records are never
+// erased; otherwise the next load picks them up and a later append checkpoints (reloading
+// here would move the slots the caller is still using)
+// Skipped after a failed journal write, since memory then holds changes that were not saved
+// Not retried until the next load, so appends do not each wait for the flusher meanwhile
+void checkpointJournal() {
+    StorageLock lock;
+    if (waitForFlush() && storageUnchanged()) saveProducts();
+    else checkpointDeferred = true;
+}
+
+// Queue one or more journal records for the next group commit
+// Call waitForCommit() and check its result before reporting the change as saved
+// The snapshot is rewritten only once the journal grows past half the catalog size
+void appendJournal(const string& records, size_t count) {
+    {
+        unique_lock<mutex> lock(journalMutex);
+        if (catalogDamaged) {
+            // The journal belongs to the unreadable snapshot: report the change as not saved
+            journalWriteFailed = true;
+            return;
+        }
+        if (!journalMatchesSnapshot) {
+            // The journal on disk belongs to another snapshot: start a fresh one first
+            journalCommitted.wait(lock, [] { return journalDurableSeq >= journalQueuedSeq; });
+            journalMatchesSnapshot = writeFileAtomic(JOURNAL_FILE, "J|" + snapshotTag + "\n");
+            journalStamp = fileStamp(JOURNAL_FILE);
+            if (!journalMatchesSnapshot) {
+                cerr << "Warning: could not write " << JOURNAL_FILE << ".\n";
+                journalWriteFailed = true;
+                return;
+            }
+        }
+        if (!journalFlusher.joinable()) journalFlusher = thread(journalFlusherLoop);
+        pendingJournal += records;
+        journalQueuedSeq++;
+    }
+    journalQueued.notify_one();
+    journalRecords += count;
+    if (!checkpointDeferred && journalRecords > max(JOURNAL_MIN_CHECKPOINT, products.size() / 2))
+        checkpointJournal();
+}
+
+// Write journal records straight away, skipping the group-commit window
+// For records the caller must have on disk before it goes on, such as ID reservations;
+// returns false if they could not be written
+bool appendJournalNow(const string& records, size_t count) {
+    StorageLock storage;
+    waitForFlush(); // Keep the records in order behind anything already queued
+    {
+        lock_guard<mutex> lock(journalMutex);
+        if (catalogDamaged) return false;
+        if (!journalMatchesSnapshot) {
+            journalMatchesSnapshot = writeFileAtomic(JOURNAL_FILE, "J|" + snapshotTag + "\n");
+            journalStamp = fileStamp(JOURNAL_FILE);
+            if (!journalMatchesSnapshot) return false;
+        }
+        FileStamp before, after;
+        if (!writeJournalBatch(records, before, after)) return false;
+        if (before == journalStamp) journalStamp = after;
+    }
+    journalRecords += count;
+    return true;
+}
+
+// Product IDs are handed out from a block reserved through the journal (hi-lo allocation):
+// allocation never looks at the products, and concurrent admin sessions get disjoint blocks
+// Each block is twice the size of the previous one, up to ID_BLOCK_MAX, so bulk adds reserve
+// rarely while a session that adds a few products leaves only a small gap of unused IDs
+const int ID_BLOCK_MIN = 100;
+const int ID_BLOCK_MAX = 10000;
+int idBlockNext = 0, idBlockEnd = 0; // Reserved but unused IDs: [idBlockNext, idBlockEnd)
+int idBlockSize = ID_BLOCK_MIN;      // Size of the next block to reserve
+
+// Return a new, never used product ID, or -1 if no block of IDs could be reserved
+// The reservation is written synchronously under the storage lock
+int allocateProductId() {
+    if (idBlockNext >= idBlockEnd) {
+        StorageLock lock;
+        loadProducts(); // Pick up blocks reserved by other sessions
+        int end = nextProductId + idBlockSize;
+        if (!appendJournalNow("H|" + to_string(end) + "\n", 1)) return -1;
+        idBlockNext = nextProductId;
+        idBlockEnd = nextProductId = end;
+        idBlockSize = min(idBlockSize * 2, ID_BLOCK_MAX);
+    }
+    return idBlockNext++;
+}
+
+// Give back the most recently allocated ID if it ended up unused
+void releaseProductId(int id) {
+    if (id == idBlockNext - 1) idBlockNext--;
 }
 
-// Display all products in a formatted table
-void displayProducts() {
+// Replace the catalog with the contents of products.txt
+// Reloads first, so the ID high-water mark covers every block reserved by any session, and drops
+// this session's block, whose IDs the imported file may already use
+void importProductsText() {
+    StorageLock lock;
+    loadProducts();
+    products.clear();
+    MappedFile file(PRODUCTS_FILE);
+    parseProductsText(file.view());
+    for (int id : products.id) nextProductId = max(nextProductId, id + 1);
+    idBlockNext = idBlockEnd = 0;
+    idBlockSize = ID_BLOCK_MIN;
+    rebuildIndexes();
+    saveProducts();
+}
+
+// Display products in a formatted table (all products unless a view is given)
+void displayProducts(const CatalogView& view = viewAllProducts()) {
     cout << "\n--- Product Catalog ---\n";
     cout << left << setw(W_ID) << "ProdID"
          << setw(W_NAME) << "Name"
@@ -128,7 +1872,8 @@ void displayProducts() {
          << setw(W_QTY) << "Qty"
          << setw(W_PRICE) << "Price" << endl;
     cout << string(W_ID + W_NAME + W_CAT + W_QTY + W_PRICE, '-') << endl;
-    for (const auto& p : products) {
+    for (size_t i = 0; i < view.size(); ++i) {
+        ProductRef p = products[view[i]];
         cout << left << setw(W_ID) << p.id
              << setw(W_NAME) << p.name
              << setw(W_CAT) << p.category
@@ -137,37 +1882,201 @@ void displayProducts() {
     }
 }
 
+// Return the products whose names contain every trigram of a lowercased key (at least 3 characters)
+// These are the only products that can contain the key; the result is in ascending order
+vector<int> trigramCandidates(const string& lowerKey) {
+    vector<const vector<int>*> lists;
+    for (uint32_t gram : trigramsOf(lowerKey)) {
+        auto it = productTrigramIndex.find(gram);
+        if (it == productTrigramIndex.end()) return {};
+        lists.push_back(&it->second);
+    }
+    sort(lists.begin(), lists.end(),
+         [](const vector<int>* a, const vector<int>* b) { return a->size() < b->size(); });
+
+    // Walk the shortest list and binary-search the others
+    vector<int> result;
+    for (int slot : *lists[0]) {
+        bool inAll = true;
+        for (size_t k = 1; k < lists.size() && inAll; ++k)
+            inAll = binary_search(lists[k]->begin(), lists[k]->end(), slot);
+        if (inAll) result.push_back(slot);
+    }
+    return result;
+}
+
+// True if the name of the product at 'slot' contains a lowercase key (ASCII case-insensitive)
+bool nameContains(int slot, const string& lowerKey) {
+    const char* name = products.names.bytes.data() + products.nameOffset[slot];
+    size_t len = products.nameLength[slot];
+    return lowerKey.empty() || findFolded(name, len, lowerKey.data(), lowerKey.size()) != len;
+}
+
+// Scan the whole name arena with a substring kernel; returns the products whose names contain
+// a lowercase key, in slot order
+vector<int> scanNameArena(SubstringKernel kernel, const string& lowerKey) {
+    vector<int> result;
+    const vector<uint32_t>& offsets = products.nameOffset;
+    const char* text = products.names.bytes.data();
+    size_t n = products.names.bytes.size(), pos = 0;
+    while (true) {
+        size_t hit = kernel(text + pos, n - pos, lowerKey.data(), lowerKey.size());
+        if (hit == n - pos) break;
+        hit += pos;
+        // Map the hit back to its product; it may instead lie in the name of a removed product,
+        // which stays in the arena, so check it falls inside a live product's own name
+        int slot = upper_bound(offsets.begin(), offsets.end(), hit) - offsets.begin() - 1;
+        if (slot >= 0 && hit < offsets[slot] + products.nameLength[slot] && products.isLive(slot)) {
+            result.push_back(slot);
+            pos = offsets[slot] + products.nameLength[slot] + 1;
+        } else {
+            pos = (size_t)(slot + 1) < offsets.size() ? offsets[slot + 1] : n;
+        }
+    }
+    return result;
+}
+
 // Find all products whose names contain the search key (case-insensitive, substring match)
+// Keys of three or more characters intersect the trigram posting lists and only check those
+// candidates; shorter keys scan the whole name arena with the SIMD kernel
 // Returns a vector of matching product indices
 vector<int> findProductsBySubstring(const string& key) {
-    string tkey = key;
-    transform(tkey.begin(), tkey.end(), tkey.begin(), ::tolower);
+    string tkey = lowercase(key);
     vector<int> result;
-    for (size_t i = 0; i < products.size(); ++i) {
-        string pname = products[i].name;
-        transform(pname.begin(), pname.end(), pname.begin(), ::tolower);
-        if (pname.find(tkey) != string::npos)
-            result.push_back(i);
+    if (tkey.empty()) {
+        for (size_t i = 0; i < products.size(); ++i)
+            if (products.isLive(i)) result.push_back(i);
+        return result;
+    }
+    if (tkey.size() < 3) return scanNameArena(findFolded, tkey);
+    for (int slot : trigramCandidates(tkey)) {
+        if (products.isLive(slot) && nameContains(slot, tkey))
+            result.push_back(slot);
+    }
+    return result;
+}
+
+// Bit-parallel approximate matcher (Myers' algorithm): one 64-bit word holds a whole column
+// of the edit-distance table, so each name character costs a handful of word operations
+// Patterns longer than 64 characters are cut to their first 64
+struct FuzzyPattern {
+    uint64_t peq[256] = {}; // Bit i set where pattern[i] equals the character (lowercased)
+    int length = 0;
+
+    explicit FuzzyPattern(const string& lowerPattern) {
+        length = min<size_t>(lowerPattern.size(), 64);
+        for (int i = 0; i < length; ++i)
+            peq[static_cast<unsigned char>(lowerPattern[i])] |= 1ULL << i;
+    }
+
+    // Smallest number of edits needed to turn the pattern into some substring of 'text'
+    int bestDistance(string_view text) const {
+        uint64_t pv = ~0ULL, mv = 0;
+        const uint64_t high = 1ULL << (length - 1);
+        int score = length, best = length;
+        for (char ch : text) {
+            uint64_t eq = peq[static_cast<unsigned char>(tolower(static_cast<unsigned char>(ch)))];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            if (ph & high) score++;
+            else if (mh & high) score--;
+            ph <<= 1; // The match may start anywhere, so the top row stays zero
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+            best = min(best, score);
+        }
+        return best;
+    }
+};
+
+// Maximum number of typo-tolerant matches returned
+const size_t FUZZY_RESULT_LIMIT = 10;
+
+// Find products whose names contain the key with a few typos, closest first
+// Allows about one edit per four characters; when the key is long enough to split into
+// (edits + 1) pieces of three or more characters, one piece must appear unchanged, so only
+// products found through the trigram index for some piece are checked
+vector<int> findProductsFuzzy(const string& key) {
+    string tkey = lowercase(trim(key));
+    if (tkey.empty()) return {};
+    if (tkey.size() > 64) tkey.resize(64);
+    int maxEdits = max<int>(1, (tkey.size() + 2) / 4);
+    if (maxEdits >= (int)tkey.size()) maxEdits = tkey.size() - 1;
+
+    vector<int> candidates;
+    size_t pieces = maxEdits + 1;
+    bool filtered = tkey.size() / pieces >= 3;
+    if (filtered) {
+        for (size_t i = 0; i < pieces; ++i) {
+            size_t from = tkey.size() * i / pieces, to = tkey.size() * (i + 1) / pieces;
+            vector<int> part = trigramCandidates(tkey.substr(from, to - from));
+            candidates.insert(candidates.end(), part.begin(), part.end());
+        }
+        sort(candidates.begin(), candidates.end());
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
     }
+
+    FuzzyPattern pattern(tkey);
+    vector<pair<int, int>> ranked; // (edits, index in products)
+    size_t count = filtered ? candidates.size() : products.size();
+    for (size_t i = 0; i < count; ++i) {
+        int slot = filtered ? candidates[i] : (int)i;
+        if (!products.isLive(slot)) continue;
+        int edits = pattern.bestDistance(products[slot].name);
+        if (edits <= maxEdits) ranked.push_back({edits, slot});
+    }
+    size_t keep = min(ranked.size(), FUZZY_RESULT_LIMIT);
+    partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end());
+    vector<int> result;
+    for (size_t i = 0; i < keep; ++i) result.push_back(ranked[i].second);
     return result;
 }
 
+// Number of suggestions shown when the user asks for completions
+const size_t AUTOCOMPLETE_LIMIT = 10;
+
+// Prompt for a product name or ID; an entry ending in '?' lists names starting
+// with the text before it and prompts again
+string readProductKey(const string& prompt) {
+    string key;
+    while (true) {
+        cout << prompt;
+        getline(cin, key);
+        if (key.empty() || key.back() != '?') return key;
+        key.pop_back();
+        vector<int> suggestions = completeProductName(trim(key), AUTOCOMPLETE_LIMIT);
+        if (suggestions.empty()) {
+            cout << "No product names start with \"" << trim(key) << "\".\n";
+            continue;
+        }
+        cout << "Suggestions:\n";
+        for (int idx : suggestions)
+            cout << "  " << products[idx].name << " (ID: " << products[idx].id << ")\n";
+    }
+}
+
 // Search for a product by (partial) name and display details
 // If multiple products match, allows the user to select one
 void searchProduct() {
-    cout << "\nEnter product name or part of it (or 'b' to go back): ";
-    string search;
-    getline(cin, search);
+    string search = readProductKey("\nEnter product name or part of it (end with '?' for suggestions, or 'b' to go back): ");
     if (search == "b" || search == "B") return;
 
     vector<int> matches = findProductsBySubstring(search);
+    bool approximate = false;
+    if (matches.empty()) {
+        matches = findProductsFuzzy(search);
+        approximate = true;
+    }
 
     if (matches.empty()) {
         cout << "No matching products found.\n";
         return;
     }
 
-    cout << "\nMatching products:\n";
+    cout << (approximate ? "\nNo exact matches. Did you mean:\n" : "\nMatching products:\n");
     for (size_t i = 0; i < matches.size(); ++i) {
         cout << i + 1 << ". " << products[matches[i]].name << " (ID: " << products[matches[i]].id << ")\n";
     }
@@ -205,19 +2114,31 @@ void searchProduct() {
     cout << "Price: " << products[idx].price << endl;
 }
 
-// Find the index of a product by exact ID or exact name
+// Find the index of a product by exact ID or exact name (case-insensitive)
+// Returns -1 if nothing matches, or AMBIGUOUS_MATCH if several products have that name
 int findProduct(const string& key) {
     string tkey = trim(key);
-    for (size_t i = 0; i < products.size(); ++i) {
-        if (to_string(products[i].id) == tkey || trim(products[i].name) == tkey)
-            return i;
+    int id;
+    if (isDigits(tkey) && parseNumber(string_view(tkey), id)) {
+        int idx = findProductIndexByID(id);
+        if (idx != -1) return idx;
     }
-    return -1;
+    auto it = productNameIndex.find(nameKey(tkey));
+    if (it == productNameIndex.end()) return -1;
+    return it->second.size() == 1 ? it->second[0] : AMBIGUOUS_MATCH;
 }
 
-// Prompt the user for a positive integer and store it in 'out'
+// Tell the user that a name matched several products and list them
+void reportAmbiguousName(const string& key) {
+    cout << "More than one product is named \"" << trim(key) << "\". Use the Product ID instead:\n";
+    for (int idx : productNameIndex[nameKey(key)])
+        cout << "  ID " << products[idx].id << ": " << products[idx].name
+             << " (" << products[idx].category << ")\n";
+}
+
+// Prompt the user for a positive integer of at most 'maxValue' and store it in 'out'
 // Returns true if successful (false if the user enters 'b')
-bool getStrictIntPositive(const string& prompt, int& out) {
+bool getStrictIntPositive(const string& prompt, int& out, int maxValue = numeric_limits<int>::max()) {
     string s;
     while (true) {
         cout << prompt;
@@ -234,7 +2155,7 @@ bool getStrictIntPositive(const string& prompt, int& out) {
                     break;
                 }
             }
-            if (!overflow && val > 0) {
+            if (!overflow && val > 0 && val <= maxValue) {
                 out = static_cast<int>(val);
                 return true;
             }
@@ -245,23 +2166,22 @@ bool getStrictIntPositive(const string& prompt, int& out) {
     }
 }
 
-// Prompt the user for a positive double and store it in 'out'
+// Prompt the user for a positive peso amount and store it in 'out'
 // Returns true if successful (false if the user enters 'b')
-bool getStrictDoublePositive(const string& prompt, double& out) {
+bool getStrictMoneyPositive(const string& prompt, Money& out) {
     string s;
     while (true) {
         cout << prompt;
         getline(cin, s);
         if (s == "b" || s == "B") return false;
         if (isValidDouble(s)) {
-            std::stringstream ss(s);
-            double val;
-            ss >> val;
-            if (!ss.fail() && ss.eof() && val > 0) {
+            Money val;
+            if (parseMoney(s, val) && val > Money()) {
                 out = val;
                 return true;
             }
-            cout << "Value must be greater than zero. Try again.\n";
+            cout << "Value must be greater than zero, at most " << Money::fromCentavos(MAX_PRICE_CENTAVOS)
+                 << ", with at most two decimals. Try again.\n";
         } else {
             cout << "Invalid input. Enter a valid price greater than zero or 'b' to go back.\n";
         }
@@ -315,77 +2235,216 @@ bool getMenuChoice(const string& prompt, int& out, int minv, int maxv) {
 // Add a new product to the inventory
 void addProduct() {
     Product p;
-    p.id = getNextID();
+    p.id = allocateProductId();
+    if (p.id == -1) {
+        cout << "\nCould not reserve a product ID. The product was not added.\n";
+        return;
+    }
     cout << "\nAssigned Product ID: " << p.id << endl;
 
-    if (!getStringWithLetter("Enter Product Name (must contain a letter, or 'b' to go back): ", p.name)) return;
-    if (!getStringWithLetter("Enter Product Category (e.g., Electronics, Apparel, etc., or 'b' to go back): ", p.category)) return;
-    if (!getStrictIntPositive("Enter Quantity (number > 0, or 'b' to go back): ", p.quantity)) return;
-    if (!getStrictDoublePositive("Enter Price (number > 0, or 'b' to go back): ", p.price)) return;
+    if (!getStringWithLetter("Enter Product Name (must contain a letter, or 'b' to go back): ", p.name)
+        || !getStringWithLetter("Enter Product Category (e.g., Electronics, Apparel, etc., or 'b' to go back): ", p.category)
+        || !getStrictIntPositive("Enter Quantity (number > 0, or 'b' to go back): ", p.quantity, MAX_QUANTITY)
+        || !getStrictMoneyPositive("Enter Price (number > 0, or 'b' to go back): ", p.price)) {
+        releaseProductId(p.id);
+        return;
+    }
 
-    products.push_back(p);
-    saveProducts("products.txt");
+    addProductToStore(p);
+    appendJournal(journalAddRecord(p), 1);
+    if (!waitForCommit()) {
+        loadProducts();
+        cout << "Could not save the product. It was not added.\n";
+        return;
+    }
     cout << "Product added successfully!\n";
 }
 
 // Update the stock of an existing product (stock in or stock out)
 void updateStock() {
     string key;
-    cout << "\nEnter Product ID or Name to update (or 'b' to go back): ";
-    getline(cin, key);
+    key = readProductKey("\nEnter Product ID or Name to update (end with '?' for suggestions, or 'b' to go back): ");
     if (key == "b" || key == "B") return;
     int idx = findProduct(key);
+    if (idx == AMBIGUOUS_MATCH) {
+        reportAmbiguousName(key);
+        return;
+    }
     if (idx == -1) {
         cout << "Product not found.\n";
         return;
     }
+    ProductHandle product = handleOf(idx);
     int opt;
     if (!getMenuChoice("1. Stock In\n2. Stock Out\nEnter choice (or 'b' to go back): ", opt, 1, 2)) return;
 
     int qty;
-    if (!getStrictIntPositive("Enter quantity (number > 0, or 'b' to go back): ", qty)) return;
+    if (!getStrictIntPositive("Enter quantity (number > 0, or 'b' to go back): ", qty, MAX_QUANTITY)) return;
+    idx = resolveHandle(product);
+    if (idx == -1) {
+        cout << "The product changed while you were entering the update. Please try again.\n";
+        return;
+    }
 
     if (opt == 1) {
-        products[idx].quantity += qty;
+        if (qty > MAX_QUANTITY - products[idx].quantity) {
+            cout << "Stock cannot exceed " << MAX_QUANTITY << " units.\n";
+            return;
+        }
+        changeStock(idx, qty);
+        appendJournal(journalStockRecord(products[idx].id, qty), 1);
+        if (!waitForCommit()) {
+            loadProducts();
+            cout << "Could not save the stock change. Stock was not updated.\n";
+            return;
+        }
         cout << "Stock increased.\n";
     } else if (opt == 2) {
         if (qty > products[idx].quantity) {
             cout << "Not enough stock.\n";
             return;
         }
-        products[idx].quantity -= qty;
+        changeStock(idx, -qty);
+        appendJournal(journalStockRecord(products[idx].id, -qty), 1);
+        if (!waitForCommit()) {
+            loadProducts();
+            cout << "Could not save the stock change. Stock was not updated.\n";
+            return;
+        }
         cout << "Stock decreased.\n";
+        if (products[idx].quantity <= REORDER_LEVEL)
+            cout << "Reorder alert: only " << products[idx].quantity << " left of " << products[idx].name << ".\n";
     }
-    saveProducts("products.txt");
 }
 
-// Calculate and display the total value of all inventory
+// Display the value and units of the inventory, per category and in total
 void inventoryValue() {
-    double total = 0;
-    for (const auto& p : products)
-        total += p.quantity * p.price;
-    cout << "\nTotal Inventory Value: " << fixed << setprecision(2) << total << endl;
+    cout << "\n--- Inventory Value by Category ---\n";
+    cout << left << setw(W_CAT) << "Category"
+         << setw(W_QTY) << "Products"
+         << setw(W_QTY) << "Units"
+         << setw(W_QTY) << "Reorder"
+         << "Value" << endl;
+    cout << string(W_CAT + 3 * W_QTY + W_PRICE, '-') << endl;
+    for (int c : getCategories()) {
+        StockTotals t = categoryStockTotals(c);
+        cout << left << setw(W_CAT) << categoryNames[c]
+             << setw(W_QTY) << categoryMembers[c].size()
+             << setw(W_QTY) << t.units
+             << setw(W_QTY) << t.reorder
+             << (t.overflow ? "over " : "") << t.value << endl;
+    }
+    StockTotals total = stockTotals();
+    cout << "\nTotal Units: " << total.units << endl;
+    cout << "Products Needing Reorder: " << total.reorder << endl;
+    cout << "Total Inventory Value: " << (total.overflow ? "over " : "") << total.value << endl;
 }
 
 // Delete a product from the inventory by ID or name
 void deleteProduct() {
     string key;
-    cout << "\nEnter Product ID or Name to delete (or 'b' to go back): ";
-    getline(cin, key);
+    key = readProductKey("\nEnter Product ID or Name to delete (end with '?' for suggestions, or 'b' to go back): ");
     if (key == "b" || key == "B") return;
     int idx = findProduct(key);
+    if (idx == AMBIGUOUS_MATCH) {
+        reportAmbiguousName(key);
+        return;
+    }
     if (idx == -1) {
         cout << "Product not found.\n";
         return;
     }
-    products.erase(products.begin() + idx);
-    saveProducts("products.txt");
+    int id = products[idx].id;
+    removeProductFromStore(idx);
+    appendJournal(journalDeleteRecord(id), 1);
+    if (!waitForCommit()) {
+        loadProducts();
+        cout << "Could not save the deletion. The product was not deleted.\n";
+        return;
+    }
     cout << "Product deleted successfully.\n";
 }
 
+// Admin views of the catalog ordered by price
+void browseByPrice() {
+    int opt;
+    if (!getMenuChoice("\n1. Products in a Price Range\n2. Cheapest Products in a Category\n"
+                       "3. All Products, Lowest Price First\n4. All Products, Highest Price First\n"
+                       "Enter choice (or 'b' to go back): ", opt, 1, 4)) return;
+    if (opt == 1) {
+        Money low, high;
+        if (!getStrictMoneyPositive("Enter minimum price (or 'b' to go back): ", low)) return;
+        if (!getStrictMoneyPositive("Enter maximum price (or 'b' to go back): ", high)) return;
+        displayProducts(viewSlots(productsInPriceRange(low, high)));
+    } else if (opt == 2) {
+        vector<int> categories = getCategories();
+        if (categories.empty()) {
+            cout << "No products available.\n";
+            return;
+        }
+        cout << "\n";
+        for (size_t i = 0; i < categories.size(); ++i)
+            cout << i + 1 << ". " << categoryNames[categories[i]] << endl;
+        int cat, n;
+        if (!getMenuChoice("Select category (or 'b' to go back): ", cat, 1, categories.size())) return;
+        if (!getStrictIntPositive("How many products to show? (or 'b' to go back): ", n)) return;
+        displayProducts(viewSlots(cheapestInCategory(categories[cat - 1], n)));
+    } else {
+        displayProducts(viewByPrice(opt == 4));
+    }
+}
+
+// List the products with the lowest stock, flagging those that need reordering
+void lowStockReport() {
+    int n;
+    if (!getStrictIntPositive("\nHow many products to list? (or 'b' to go back): ", n)) return;
+    vector<int> critical = lowestStock(n);
+    cout << "\n--- Low Stock Report ---\n";
+    cout << left << setw(W_ID) << "ProdID"
+         << setw(W_NAME) << "Name"
+         << setw(W_CAT) << "Category"
+         << setw(W_QTY) << "Qty" << endl;
+    cout << string(W_ID + W_NAME + W_CAT + W_QTY + 8, '-') << endl;
+    for (int idx : critical) {
+        ProductRef p = products[idx];
+        cout << left << setw(W_ID) << p.id
+             << setw(W_NAME) << p.name
+             << setw(W_CAT) << p.category
+             << setw(W_QTY) << p.quantity
+             << (p.quantity <= REORDER_LEVEL ? "REORDER" : "") << endl;
+    }
+}
+
+// Export the catalog to products.txt
+void exportCatalog() {
+    exportProductsText();
+    cout << "Exported " << products.liveCount() << " products to " << PRODUCTS_FILE << ".\n";
+}
+
+// Replace the catalog with products.txt after confirmation
+void importCatalog() {
+    cout << "\nThis replaces the current catalog with the contents of " << PRODUCTS_FILE << ". Continue? (Y/N): ";
+    string yn;
+    getline(cin, yn);
+    if (!(yn.length() && (yn[0] == 'y' || yn[0] == 'Y'))) {
+        cout << "Import cancelled.\n";
+        return;
+    }
+    importProductsText();
+    cout << "Imported " << products.liveCount() << " products from " << PRODUCTS_FILE << ".\n";
+}
+
 // Inventory management menu for admin actions
 void inventoryMenu() {
-    loadProducts("products.txt");
+    loadProducts();
+    if (catalogDamaged) {
+        cout << "The admin panel is unavailable until " << CATALOG_FILE << " is repaired.\n";
+        return;
+    }
+    size_t reorder = countReorderNeeded();
+    if (reorder > 0)
+        cout << "\nReorder alert: " << reorder << " product(s) have " << REORDER_LEVEL
+             << " or fewer units left. See option 10.\n";
     while (true) {
         cout << "\n--- Inventory Management Panel ---\n";
         cout << "1. Add New Product\n";
@@ -394,9 +2453,13 @@ void inventoryMenu() {
         cout << "4. Display All Products\n";
         cout << "5. Calculate Inventory Value\n";
         cout << "6. Delete a Product\n";
+        cout << "7. Export Catalog to products.txt\n";
+        cout << "8. Import Catalog from products.txt\n";
+        cout << "9. Browse Products by Price\n";
+        cout << "10. Low Stock Report\n";
         cout << "0. Exit Admin Panel\n";
         int choice;
-        if (!getMenuChoice("Enter choice (or 'b' to go back): ", choice, 0, 6)) continue;
+        if (!getMenuChoice("Enter choice (or 'b' to go back): ", choice, 0, 10)) continue;
         switch (choice) {
             case 1: addProduct(); break;
             case 2: updateStock(); break;
@@ -404,6 +2467,10 @@ void inventoryMenu() {
             case 4: displayProducts(); break;
             case 5: inventoryValue(); break;
             case 6: deleteProduct(); break;
+            case 7: exportCatalog(); break;
+            case 8: importCatalog(); break;
+            case 9: browseByPrice(); break;
+            case 10: lowStockReport(); break;
             case 0: return;
             default: cout << "Invalid choice.\n";
         }
@@ -411,35 +2478,37 @@ void inventoryMenu() {
 }
 
 // Helper function for product category selection during order placement
-vector<const Product*> getCatalogSelectionForOrder(bool& backSelected) {
+CatalogView getCatalogSelectionForOrder(bool& backSelected) {
     backSelected = false;
-    loadProducts("products.txt");
-    if (products.empty()) {
+    loadProducts();
+    if (products.liveCount() == 0) {
         cout << "\n--- Catalog ---\nNo products available. Please ask admin to add products.\n";
         return {};
     }
-    vector<string> categories = getCategories();
+    vector<int> categories = getCategories();
     while (true) {
         cout << "\n--- Product Categories ---\n";
         cout << "A. Show All Products\n";
         cout << "R. Suggest Me a Random Product\n";
+        cout << "P. Products in a Price Range\n";
+        cout << "L. All Products, Lowest Price First\n";
+        cout << "H. All Products, Highest Price First\n";
         for (size_t i = 0; i < categories.size(); ++i) {
-            cout << i + 1 << ". " << categories[i] << endl;
+            cout << i + 1 << ". " << categoryNames[categories[i]] << endl;
         }
         cout << "B. Back\n";
-        cout << "Select category (enter number, 'A' for all, 'R' for random, or 'B' to go back): ";
+        cout << "Select category (enter number, a letter option, or 'B' to go back): ";
         string catChoiceStr;
         getline(cin, catChoiceStr);
 
         if (catChoiceStr.length() == 1 && (catChoiceStr[0] == 'A' || catChoiceStr[0] == 'a')) {
-            vector<const Product*> toDisplay;
-            for (const auto& p : products) toDisplay.push_back(&p);
-            return toDisplay;
+            return viewAllProducts();
         } else if (catChoiceStr.length() == 1 && (catChoiceStr[0] == 'R' || catChoiceStr[0] == 'r')) {
             random_device rd;
             mt19937 gen(rd());
-            uniform_int_distribution<> dis(0, products.size() - 1);
-            int randIdx = dis(gen);
+            CatalogView everything = viewAllProducts();
+            uniform_int_distribution<> dis(0, everything.size() - 1);
+            int randIdx = everything[dis(gen)];
             cout << "\nRandom Product Suggestion:\n";
             cout << "Name: " << products[randIdx].name << endl;
             cout << "Category: " << products[randIdx].category << endl;
@@ -449,12 +2518,24 @@ vector<const Product*> getCatalogSelectionForOrder(bool& backSelected) {
             string yn;
             getline(cin, yn);
             if (yn.length() && (yn[0] == 'y' || yn[0] == 'Y')) {
-                vector<const Product*> suggestion;
-                suggestion.push_back(&products[randIdx]);
-                return suggestion;
+                return viewSlots({randIdx});
             } else {
                 continue;
             }
+        } else if (catChoiceStr.length() == 1 && (catChoiceStr[0] == 'P' || catChoiceStr[0] == 'p')) {
+            Money low, high;
+            if (!getStrictMoneyPositive("Enter minimum price (or 'b' to go back): ", low)) continue;
+            if (!getStrictMoneyPositive("Enter maximum price (or 'b' to go back): ", high)) continue;
+            vector<int> inRange = productsInPriceRange(low, high);
+            if (inRange.empty()) {
+                cout << "No products in that price range.\n";
+                continue;
+            }
+            return viewSlots(move(inRange));
+        } else if (catChoiceStr.length() == 1 && (catChoiceStr[0] == 'L' || catChoiceStr[0] == 'l')) {
+            return viewByPrice(false);
+        } else if (catChoiceStr.length() == 1 && (catChoiceStr[0] == 'H' || catChoiceStr[0] == 'h')) {
+            return viewByPrice(true);
         } else if (catChoiceStr.length() == 1 && (catChoiceStr[0] == 'B' || catChoiceStr[0] == 'b')) {
             backSelected = true;
             return {};
@@ -463,12 +2544,7 @@ vector<const Product*> getCatalogSelectionForOrder(bool& backSelected) {
             if (catChoice < 1 || catChoice > (int)categories.size()) {
                 cout << "Invalid input. Try again.\n";
             } else {
-                string selectedCat = categories[catChoice - 1];
-                vector<const Product*> toDisplay;
-                for (const auto& p : products)
-                    if (p.category == selectedCat)
-                        toDisplay.push_back(&p);
-                return toDisplay;
+                return viewCategory(categories[catChoice - 1]);
             }
         } else {
             cout << "Invalid input. Try again.\n";
@@ -477,7 +2553,7 @@ vector<const Product*> getCatalogSelectionForOrder(bool& backSelected) {
 }
 
 // Prompt the user for a payment method and handle E-Wallet confirmation
-void selectPaymentMethod(string& paymentMethod, double total) {
+void selectPaymentMethod(string& paymentMethod, Money total) {
     int paymentChoice;
     int attemptCounter = 0;
     const int maxAttempts = 3;
@@ -558,21 +2634,76 @@ void selectPaymentMethod(string& paymentMethod, double total) {
     }
 }
 
+// One product in a customer's cart
+// The product ID is kept so the line can be re-resolved if the catalog is reloaded
+struct CartLine {
+    ProductHandle product;
+    int productId;
+    int quantity;
+};
+
+// Slot of the product on a cart line, re-resolving the handle by product ID if the catalog
+// was reloaded since the line was added; -1 if the product no longer exists
+int resolveCartLine(CartLine& line) {
+    int slot = resolveHandle(line.product);
+    if (slot == -1) {
+        slot = findProductIndexByID(line.productId);
+        if (slot != -1) line.product = handleOf(slot);
+    }
+    return slot;
+}
+
+// A customer's cart: one line per product, in the order first added
+// Lines are found through a hash map, so adding to the cart costs O(1) and the summary,
+// stock deduction and receipt cost O(items in cart) whatever the size of the catalog
+// The map is keyed by product ID rather than by handle, because a line's handle is
+// re-issued when the catalog reloads
+struct Cart {
+    vector<CartLine> lines;
+    unordered_map<int, size_t> lineOfProduct; // Product ID -> index in lines
+
+    bool empty() const { return lines.empty(); }
+    // The line holding a product, or nullptr if it is not in the cart
+    CartLine* find(int productId) {
+        auto it = lineOfProduct.find(productId);
+        return it == lineOfProduct.end() ? nullptr : &lines[it->second];
+    }
+    // Add 'quantity' of a product, merging with its existing line
+    void add(ProductHandle product, int productId, int quantity) {
+        if (CartLine* line = find(productId)) {
+            line->quantity += quantity;
+            return;
+        }
+        lineOfProduct.emplace(productId, lines.size());
+        lines.push_back({product, productId, quantity});
+    }
+    // Drop every line whose quantity is zero, keeping the order of the rest
+    void removeEmptyLines() {
+        lines.erase(remove_if(lines.begin(), lines.end(), [](const CartLine& l) { return l.quantity == 0; }), lines.end());
+        lineOfProduct.clear();
+        for (size_t i = 0; i < lines.size(); ++i) lineOfProduct.emplace(lines[i].productId, i);
+    }
+};
+
 // Main function for placing an order (buying products)
 void placeOrder() {
-    loadProducts("products.txt");
-    if (products.empty()) {
+    loadProducts();
+    if (catalogDamaged) {
+        cout << "Orders cannot be taken right now. Please ask admin to repair the product catalog.\n";
+        return;
+    }
+    if (products.liveCount() == 0) {
         cout << "No products available to order. Please ask admin to add products first.\n";
         return;
     }
-    vector<int> cartQuantities(products.size(), 0);
-    double total = 0;
+    Cart cart;
+    Money total;
     string paymentMethod;
     bool orderCancelled = false;
 
     while (true) {
         bool backSelected = false;
-        vector<const Product*> catalog = getCatalogSelectionForOrder(backSelected);
+        CatalogView catalog = getCatalogSelectionForOrder(backSelected);
         if (backSelected) break;
         if (catalog.empty()) continue;
 
@@ -584,11 +2715,12 @@ void placeOrder() {
              << setw(W_QTY) << "Stock" << endl;
         cout << string(4 + W_NAME + W_CAT + W_PRICE + W_QTY, '-') << endl;
         for (size_t i = 0; i < catalog.size(); ++i) {
+            ProductRef p = products[catalog[i]];
             cout << left << setw(4) << (i + 1)
-                 << setw(W_NAME) << catalog[i]->name
-                 << setw(W_CAT) << catalog[i]->category
-                 << setw(W_PRICE) << fixed << setprecision(2) << catalog[i]->price
-                 << setw(W_QTY) << catalog[i]->quantity << endl;
+                 << setw(W_NAME) << p.name
+                 << setw(W_CAT) << p.category
+                 << setw(W_PRICE) << fixed << setprecision(2) << p.price
+                 << setw(W_QTY) << p.quantity << endl;
         }
 
         while (true) {
@@ -609,18 +2741,7 @@ void placeOrder() {
                 cout << "Invalid choice. Try again.\n";
                 continue;
             }
-            int catalogIdx = itemNum - 1;
-            int prodIdx = -1;
-            for (size_t i = 0; i < products.size(); ++i) {
-                if (&products[i] == catalog[catalogIdx]) {
-                    prodIdx = i;
-                    break;
-                }
-            }
-            if (prodIdx == -1) {
-                cout << "Product not found. Try again.\n";
-                continue;
-            }
+            ProductHandle selected = catalog.handleAt(itemNum - 1);
             int quantity;
             cout << "Enter quantity: ";
             string qtyStr;
@@ -630,11 +2751,18 @@ void placeOrder() {
                 continue;
             }
             quantity = stoi(qtyStr);
-            if (quantity <= 0 || quantity > products[prodIdx].quantity - cartQuantities[prodIdx]) {
+            int prodIdx = resolveHandle(selected);
+            if (prodIdx == -1) {
+                cout << "Product not found. Try again.\n";
+                continue;
+            }
+            CartLine* line = cart.find(products[prodIdx].id);
+            int inCart = line ? line->quantity : 0;
+            if (quantity <= 0 || quantity > products[prodIdx].quantity - inCart) {
                 cout << "Invalid quantity or not enough stock.\n";
                 continue;
             }
-            cartQuantities[prodIdx] += quantity;
+            cart.add(selected, products[prodIdx].id, quantity);
             cout << "Added to cart: " << products[prodIdx].name << " x" << quantity << endl;
         }
         if (orderCancelled) break;
@@ -652,9 +2780,19 @@ void placeOrder() {
         cout << "Order cancelled.\n";
         return;
     }
-    bool hasOrder = false;
-    for (int qty : cartQuantities) if (qty > 0) hasOrder = true;
-    if (!hasOrder) {
+    // Drop lines whose product disappeared in a reload, and cap lines whose stock shrank
+    for (auto& line : cart.lines) {
+        int slot = resolveCartLine(line);
+        if (slot == -1) {
+            cout << "Product ID " << line.productId << " is no longer available and was removed from your cart.\n";
+            line.quantity = 0;
+        } else if (line.quantity > products[slot].quantity) {
+            line.quantity = products[slot].quantity;
+            cout << "Only " << line.quantity << " of " << products[slot].name << " left; your cart was updated.\n";
+        }
+    }
+    cart.removeEmptyLines();
+    if (cart.empty()) {
         cout << "No products were added to your cart. Order cancelled.\n";
         return;
     }
@@ -662,13 +2800,15 @@ void placeOrder() {
     cout << "\n--- Order Summary ---\n";
     cout << left << setw(25) << "Product" << setw(10) << "Qty" << setw(20) << "Total Cost" << endl;
     cout << "------------------------------------------------\n";
-    total = 0;
-    for (size_t i = 0; i < products.size(); ++i) {
-        if (cartQuantities[i] > 0) {
-            double cost = cartQuantities[i] * products[i].price;
-            total += cost;
-            cout << left << setw(25) << products[i].name << setw(10) << cartQuantities[i] << cost << " pesos" << endl;
+    total = Money();
+    for (const auto& line : cart.lines) {
+        ProductRef p = products[line.product.slot];
+        Money cost = p.price * line.quantity;
+        if (!addMoney(total, cost)) {
+            cout << "The order total is too large. Please split it into smaller orders.\n";
+            return;
         }
+        cout << left << setw(25) << p.name << setw(10) << line.quantity << cost << " pesos" << endl;
     }
     cout << "------------------------------------------------\n";
     cout << "Grand Total: " << fixed << setprecision(2) << total << " pesos" << endl;
@@ -681,12 +2821,20 @@ void placeOrder() {
         return;
     }
 
-    for (size_t i = 0; i < products.size(); ++i) {
-        if (cartQuantities[i] > 0) {
-            products[i].quantity -= cartQuantities[i];
-        }
+    // Record the whole sale with one journal append
+    string saleRecords;
+    size_t saleCount = 0;
+    for (const auto& line : cart.lines) {
+        changeStock(line.product.slot, -line.quantity);
+        saleRecords += journalStockRecord(line.productId, -line.quantity);
+        saleCount++;
+    }
+    appendJournal(saleRecords, saleCount);
+    if (!waitForCommit()) {
+        loadProducts();
+        cout << "Your order could not be saved, so nothing was charged. Please try again.\n";
+        return;
     }
-    saveProducts("products.txt");
 
     // Modified payment method selection loop to handle "Back" option
     do {
@@ -712,14 +2860,13 @@ void placeOrder() {
     // Reset fill character to space so tables do not use '0' as fill character
     cout << setfill(' ');
     cout << "-----------------------------\n";
-    for (size_t i = 0; i < products.size(); ++i) {
-        if (cartQuantities[i] > 0) {
-            double cost = cartQuantities[i] * products[i].price;
-            cout << "Item: " << products[i].name << endl;
-            cout << "Qty: " << cartQuantities[i] << endl;
-            cout << "Subtotal: " << fixed << setprecision(2) << cost << " Pesos" << endl;
-            cout << endl;
-        }
+    for (const auto& line : cart.lines) {
+        ProductRef p = products[line.product.slot];
+        Money cost = p.price * line.quantity;
+        cout << "Item: " << p.name << endl;
+        cout << "Qty: " << line.quantity << endl;
+        cout << "Subtotal: " << fixed << setprecision(2) << cost << " Pesos" << endl;
+        cout << endl;
     }
     cout << "-----------------------------\n";
     cout << "Total: " << fixed << setprecision(2) << total << " pesos\n";
@@ -727,8 +2874,220 @@ void placeOrder() {
     cout << "\nThank you for shopping with us!\n";
 }
 
+// Sell the products listed as "id|qty|id|qty..." in one all-or-nothing order
+string batchOrder(string_view args, bool& ok) {
+    Cart cart;
+    while (!args.empty()) {
+        int id, qty;
+        if (!parseNumber(nextField(args), id) || !parseNumber(nextField(args), qty) || qty <= 0)
+            return "ERROR expected ORDER|id|qty[|id|qty...] with quantities > 0";
+        int slot = findProductIndexByID(id);
+        if (slot == -1) return "ERROR unknown product ID " + to_string(id);
+        cart.add(handleOf(slot), id, qty);
+    }
+    if (cart.empty()) return "ERROR empty order";
+    for (const auto& line : cart.lines) {
+        if (line.quantity > products[line.product.slot].quantity)
+            return "ERROR not enough stock of product ID " + to_string(line.productId);
+    }
+    Money total;
+    for (const auto& line : cart.lines) {
+        if (!addMoney(total, products[line.product.slot].price * line.quantity))
+            return "ERROR order total too large";
+    }
+    string saleRecords;
+    for (const auto& line : cart.lines) {
+        changeStock(line.product.slot, -line.quantity);
+        saleRecords += journalStockRecord(line.productId, -line.quantity);
+    }
+    appendJournal(saleRecords, cart.lines.size());
+    ok = true;
+    return "OK order of " + to_string(cart.lines.size()) + " product(s), total " + formatMoney(total);
+}
+
+// Add a product from "name|category|qty|price"
+string batchAdd(string_view args, bool& ok) {
+    Product p;
+    p.name = trim(nextField(args));
+    p.category = trim(nextField(args));
+    if (!containsLetter(p.name) || !containsLetter(p.category)) return "ERROR name and category must contain a letter";
+    if (!parseNumber(nextField(args), p.quantity) || p.quantity <= 0 || p.quantity > MAX_QUANTITY)
+        return "ERROR quantity must be a number from 1 to " + to_string(MAX_QUANTITY);
+    if (!parseMoney(nextField(args), p.price) || p.price <= Money())
+        return "ERROR price must be > 0 and at most " + formatMoney(Money::fromCentavos(MAX_PRICE_CENTAVOS))
+             + ", with at most two decimals";
+    if (!args.empty()) return "ERROR expected ADD|name|category|qty|price";
+    p.id = allocateProductId();
+    if (p.id == -1) return "ERROR could not reserve a product ID";
+    addProductToStore(p);
+    appendJournal(journalAddRecord(p), 1);
+    ok = true;
+    return "OK added product ID " + to_string(p.id);
+}
+
+// Stock in (positive delta) or stock out (negative delta) from "id|delta"
+string batchStock(string_view args, bool& ok) {
+    int id, delta;
+    if (!parseNumber(nextField(args), id) || !parseNumber(nextField(args), delta) || delta == 0 || !args.empty())
+        return "ERROR expected STOCK|id|delta with a non-zero delta";
+    int slot = findProductIndexByID(id);
+    if (slot == -1) return "ERROR unknown product ID " + to_string(id);
+    if (-delta > products[slot].quantity) return "ERROR not enough stock of product ID " + to_string(id);
+    if (delta > MAX_QUANTITY - products[slot].quantity)
+        return "ERROR stock of product ID " + to_string(id) + " cannot exceed " + to_string(MAX_QUANTITY);
+    changeStock(slot, delta);
+    appendJournal(journalStockRecord(id, delta), 1);
+    ok = true;
+    int left = products[slot].quantity;
+    return "OK product ID " + to_string(id) + " now has " + to_string(left) + (left <= REORDER_LEVEL ? " (reorder)" : "");
+}
+
+// Delete a product from "id"
+string batchDelete(string_view args, bool& ok) {
+    int id;
+    if (!parseNumber(nextField(args), id) || !args.empty()) return "ERROR expected DELETE|id";
+    int slot = findProductIndexByID(id);
+    if (slot == -1) return "ERROR unknown product ID " + to_string(id);
+    removeProductFromStore(slot);
+    appendJournal(journalDeleteRecord(id), 1);
+    ok = true;
+    return "OK deleted product ID " + to_string(id);
+}
+
+// Headless batch mode (run with --batch [file], reading standard input without a file)
+// One pipe-delimited command per line:
+//   ORDER|id|qty[|id|qty...]      sell the listed products, all or nothing
+//   ADD|name|category|qty|price   add a product with a newly allocated ID
+//   STOCK|id|delta                stock in (delta > 0) or stock out (delta < 0)
+//   DELETE|id                     delete a product
+// Blank lines and lines starting with '#' are skipped. Every command prints one result line
+// ("<line>: OK ..." or "<line>: ERROR ..."); the summary goes to standard error
+// Journal records are group-committed in the background as commands run and synced once at
+// the end, instead of waiting for the disk after every command
+// Returns the exit status: 0 if every command succeeded
+int runBatch(istream& in) {
+    auto start = chrono::steady_clock::now();
+    loadProducts();
+    if (catalogDamaged) return 1;
+    size_t lineNumber = 0, succeeded = 0, failed = 0;
+    string line;
+    while (getline(in, line)) {
+        lineNumber++;
+        string_view rest = line;
+        if (!rest.empty() && rest.back() == '\r') rest.remove_suffix(1);
+        if (rest.empty() || rest[0] == '#') continue;
+        string_view command = nextField(rest);
+        bool ok = false;
+        string result;
+        if (command == "ORDER") result = batchOrder(rest, ok);
+        else if (command == "ADD") result = batchAdd(rest, ok);
+        else if (command == "STOCK") result = batchStock(rest, ok);
+        else if (command == "DELETE") result = batchDelete(rest, ok);
+        else result = "ERROR unknown command \"" + string(command) + "\"";
+        (ok ? succeeded : failed)++;
+        cout << lineNumber << ": " << result << '\n';
+    }
+    bool saved = waitForCommit();
+    cout.flush();
+    if (!saved) {
+        cerr << "Error: some changes could not be saved to " << JOURNAL_FILE << ".\n";
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t commands = succeeded + failed;
+    cerr << "Processed " << commands << " commands (" << succeeded << " OK, " << failed << " failed) in "
+         << fixed << setprecision(3) << seconds << " s";
+    if (seconds > 0) cerr << ", " << setprecision(0) << commands / seconds << " commands/s";
+    cerr << endl;
+    return failed == 0 ? 0 : 1;
+}
+
+// Microbenchmark for substring search (run with --bench-search)
+// Builds a synthetic in-memory catalog and times the original lowercase-copy search against
+// each substring kernel; no files are read or written
+void benchSearch() {
+    const int N = 200000;
+    const char* words[] = {"Laptop", "T-Shirt", "Mouse", "Keyboard", "Coffee", "Rice", "Notebook", "Charger"};
+    products.clear();
+    for (int i = 0; i < N; ++i) {
+        Product p;
+        p.id = i + 1;
+        p.name = string(words[i % 8]) + " Model " + to_string(i * 7919 % 100000);
+        p.category = "Bench";
+        p.quantity = 1;
+        p.price = Money::fromCentavos(100);
+        products.push_back(p);
+    }
+    rebuildIndexes();
+
+    const vector<string> queries = {"model 4242", "xyz", "SHIRT", "e 9"};
+    auto timeIt = [](auto fn) {
+        auto start = chrono::steady_clock::now();
+        size_t hits = fn();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return make_pair(ms, hits);
+    };
+    // Full scan of the name arena, as findProductsBySubstring does for short keys
+    auto scanWith = [](SubstringKernel kernel, const string& lowerKey) {
+        return scanNameArena(kernel, lowerKey).size();
+    };
+
+    vector<pair<string, SubstringKernel>> kernels = {{"scalar", findFoldedScalar}};
+#ifdef HAVE_X86_SIMD
+    kernels.push_back({"sse2", findFoldedSse2});
+    if (__builtin_cpu_supports("avx2")) kernels.push_back({"avx2", findFoldedAvx2});
+#endif
+
+    cout << "Substring search over " << N << " names (ms per query, best of 5)\n";
+    for (const string& q : queries) {
+        string lowerKey = lowercase(q);
+        double baseline = 1e18;
+        size_t baseHits = 0;
+        for (int rep = 0; rep < 5; ++rep) {
+            auto r = timeIt([&] {
+                // The original findProductsBySubstring path: a lowercased copy of every name
+                size_t hits = 0;
+                for (size_t i = 0; i < products.size(); ++i) {
+                    string pname(products[i].name);
+                    transform(pname.begin(), pname.end(), pname.begin(), ::tolower);
+                    if (pname.find(lowerKey) != string::npos) hits++;
+                }
+                return hits;
+            });
+            baseline = min(baseline, r.first);
+            baseHits = r.second;
+        }
+        cout << "\nQuery \"" << q << "\" (" << baseHits << " matches)\n";
+        cout << "  " << left << setw(20) << "transform + find" << fixed << setprecision(3) << baseline << endl;
+        for (const auto& k : kernels) {
+            double best = 1e18;
+            size_t hits = 0;
+            for (int rep = 0; rep < 5; ++rep) {
+                auto r = timeIt([&] { return scanWith(k.second, lowerKey); });
+                best = min(best, r.first);
+                hits = r.second;
+            }
+            cout << "  " << left << setw(20) << k.first << fixed << setprecision(3) << best
+                 << "  (" << setprecision(1) << baseline / best << "x" << (hits == baseHits ? "" : ", MISMATCH") << ")\n";
+        }
+    }
+}
+
 // Main menu for the product ordering system
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--bench-search") {
+        benchSearch();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        if (argc < 3) return runBatch(cin);
+        ifstream commands(argv[2]);
+        if (!commands) {
+            cerr << "Cannot open " << argv[2] << ".\n";
+            return 1;
+        }
+        return runBatch(commands);
+    }
     string choice;
     do {
         cout << "\n--- Product Ordering System ---\n";
@@ -749,6 +3108,7 @@ int main() {
 
         switch (menuChoice) {
             case 1:
+                loadProducts();
                 displayProducts();
                 break;
             case 2: